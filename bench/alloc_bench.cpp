@@ -0,0 +1,163 @@
+// Heap allocations per input of a warm `ParseSession`, in every mode. The
+// global allocation functions are replaced by counting ones. Each mode
+// runs once over the inputs to size the session's buffers and `out`, then
+// again with the count on. Fails if a mode that reuses its buffers, i.e.
+// all but `Trace` and `Compile`, allocates at all in the second run.
+//
+//   alloc_bench [--lines N] [--seed N] [--error-rate P]
+
+#include "parser/parser.h"
+#include "workload.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> counting{false};
+std::atomic<ep::usize> allocations{0};
+
+void *allocate(std::size_t size) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size == 0 ? 1 : size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *allocate(std::size_t size, std::align_val_t alignment) {
+  if (counting.load(std::memory_order_relaxed))
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  auto align = static_cast<std::size_t>(alignment);
+  if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align))
+    return p;
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+  return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, alignment);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+using namespace ep;
+
+int main(int argc, char *argv[]) {
+  usize line_count = 10000;
+  u64 seed = 1;
+  bench::ExpressionShape shape{.error_rate = 0.1};
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--lines") == 0) {
+      line_count = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = std::strtoull(argv[i + 1], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--error-rate") == 0) {
+      shape.error_rate = std::strtod(argv[i + 1], nullptr);
+    } else {
+      std::cerr << std::format("Unknown option {}\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  bench::ExpressionGenerator generator(shape, seed);
+  std::vector<std::string> lines(line_count);
+  for (auto &line : lines)
+    generator.append_expression(line);
+
+  CompiledGrammar grammar(static_grammar<bench::expression_grammar>);
+
+  constexpr struct {
+    std::string_view name;
+    ParseMode mode;
+    bool reuses_buffers;
+  } modes[] = {
+      {"recognize",  ParseMode::Recognize,  true },
+      {"derivation", ParseMode::Derivation, true },
+      {"ast",        ParseMode::Ast,        true },
+      {"eval",       ParseMode::Evaluate,   true },
+      {"compile",    ParseMode::Compile,    false},
+      {"trace",      ParseMode::Trace,      false},
+  };
+
+  std::cout << std::format(
+      "{:<12}{:>10}{:>14}{:>12}\n", "mode", "accepted", "allocations",
+      "per input"
+  );
+  bool failed = false;
+  for (const auto &[name, mode, reuses_buffers] : modes) {
+    ParseSession session(grammar);
+    session.set_mode(mode);
+    std::string out;
+    for (const auto &line : lines) {
+      out.clear();
+      session.run(line, out);
+    }
+
+    usize accepted = 0;
+    allocations = 0;
+    counting = true;
+    for (const auto &line : lines) {
+      out.clear();
+      accepted += session.run(line, out);
+    }
+    counting = false;
+
+    usize count = allocations;
+    failed |= reuses_buffers && count != 0;
+    std::cout << std::format(
+        "{:<12}{:>10}{:>14}{:>12.2f}\n", name, accepted, count,
+        static_cast<double>(count) / static_cast<double>(lines.size())
+    );
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
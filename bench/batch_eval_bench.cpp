@@ -0,0 +1,209 @@
+// Rows per second of `BatchEvaluator` running the bytecode of generated
+// expressions over columns of random bindings, one column per variable.
+// The values are mostly small, zeros included, with now and then one near
+// the ends of the range, so that some rows divide by zero or overflow. The
+// first `--check` rows of each expression are checked against `Evaluator`,
+// by parsing the expression with the values of the row in place of its
+// variables: the verdicts must agree, and so must the values of the rows
+// without errors. Each measurement is the fastest of `--rounds` runs.
+//
+//   batch_eval_bench [--rows N] [--check N] [--expressions N] [--seed N]
+//                    [--rounds N]
+
+#include "eval/bytecode.h"
+#include "parser/parser.h"
+#include "simple_lexer/lexer.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+// The buffers of parsing one source down to its AST.
+struct Parsed {
+  std::vector<Token> tokens{};
+  std::vector<Symbol> symbols{};
+  Tree parse_tree{};
+  Tree ast{};
+};
+
+// Parses `src` into `parsed`; false if it is rejected.
+bool parse(
+    const CompiledGrammar &grammar, std::string_view src, Parsed &parsed
+) {
+  parsed.tokens.clear();
+  Lexer lexer(src);
+  for (std::optional<Token> token; (token = lexer.next_token());)
+    if (!std::holds_alternative<Whitespace>(*token))
+      parsed.tokens.push_back(*token);
+  grammar.convert_lexeme_to_symbol(parsed.tokens, parsed.symbols);
+  parsed.symbols.push_back(Symbol::end_symbol());
+  if (!grammar.build_parse_tree(parsed.symbols, parsed.parse_tree))
+    return false;
+  grammar.build_ast(parsed.parse_tree, parsed.ast);
+  return true;
+}
+
+// `src` with each variable replaced by its value in `row` of `columns`, a
+// negative one written as a subtraction, there being no unary minus.
+std::string bind_row(
+    std::string_view src, const Parsed &parsed, const Program &program,
+    const std::vector<std::vector<i64>> &columns, usize row
+) {
+  std::string bound;
+  usize copied = 0;
+  for (const auto &token : parsed.tokens) {
+    const auto *identifier = std::get_if<Identifier>(&token);
+    if (!identifier)
+      continue;
+    auto [offset, length] = identifier->span;
+    auto name = src.substr(offset, length);
+    auto variable = static_cast<usize>(
+        std::find(program.variables.begin(), program.variables.end(), name) -
+        program.variables.begin()
+    );
+    auto value = columns[variable][row];
+    bound.append(src.substr(copied, offset - copied));
+    if (value < 0)
+      std::format_to(
+          std::back_inserter(bound), "(0-{})", -static_cast<u64>(value)
+      );
+    else
+      std::format_to(std::back_inserter(bound), "{}", value);
+    copied = offset + length;
+  }
+  bound.append(src.substr(copied));
+  return bound;
+}
+
+u8 status_of(EvalError::Kind kind) {
+  return kind == EvalError::DivideByZero ? BatchEvaluator::divide_by_zero
+                                         : BatchEvaluator::overflow;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  usize row_count = 1000000, check_count = 5000, expression_count = 8;
+  usize rounds = 3;
+  u64 seed = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    auto value = std::strtoull(argv[i + 1], nullptr, 10);
+    if (std::strcmp(argv[i], "--rows") == 0) {
+      row_count = value;
+    } else if (std::strcmp(argv[i], "--check") == 0) {
+      check_count = value;
+    } else if (std::strcmp(argv[i], "--expressions") == 0) {
+      expression_count = value;
+    } else if (std::strcmp(argv[i], "--seed") == 0) {
+      seed = value;
+    } else if (std::strcmp(argv[i], "--rounds") == 0) {
+      rounds = std::max<usize>(value, 1);
+    } else {
+      std::cerr << std::format("Unknown option {}\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+  check_count = std::min(check_count, row_count);
+
+  CompiledGrammar grammar(static_grammar<bench::expression_grammar>);
+  Evaluator evaluator(grammar.symbols());
+  bench::ExpressionGenerator generator({}, seed);
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<i64> small(-1000, 1000);
+  std::uniform_int_distribution<i64> large(
+      std::numeric_limits<i64>::max() / 4, std::numeric_limits<i64>::max()
+  );
+  std::bernoulli_distribution extreme(0.01), negative(0.5);
+
+  std::cout << std::format(
+      "{:>6}{:>8}{:>12}{:>10}{:>12}  {}\n", "vars", "instrs", "Mrows/s",
+      "errors", "mismatches", "expression"
+  );
+  usize mismatches = 0;
+  BatchEvaluator batch;
+  Parsed parsed, bound_parsed;
+  std::vector<i64> results(row_count);
+  std::vector<u8> status(row_count);
+  for (usize done = 0; done < expression_count;) {
+    // Only expressions with variables take bindings.
+    std::string src;
+    generator.append_expression(src);
+    if (!parse(grammar, src, parsed))
+      continue;
+    auto compiled = compile(parsed.ast, parsed.tokens, src, grammar.ops());
+    const auto *program = std::get_if<Program>(&compiled);
+    if (!program || program->variables.empty())
+      continue;
+    ++done;
+
+    std::vector<std::vector<i64>> columns(program->variables.size());
+    for (auto &column : columns) {
+      column.resize(row_count);
+      for (auto &value : column) {
+        value = small(rng);
+        if (extreme(rng))
+          value = negative(rng) ? -large(rng) : large(rng);
+      }
+    }
+    std::vector<std::span<const i64>> bindings(columns.begin(), columns.end());
+
+    double best = 1e300;
+    for (usize round = 0; round < rounds; ++round) {
+      auto start = std::chrono::steady_clock::now();
+      batch.evaluate(*program, bindings, results, status);
+      best = std::min(
+          best, std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start
+                )
+                    .count()
+      );
+    }
+
+    // A row without errors runs the same operations on the same values in
+    // both, and a row with one fails the same operation first, though the
+    // batch goes on and may flag more after it.
+    usize expression_mismatches = 0;
+    for (usize row = 0; row < check_count; ++row) {
+      auto bound = bind_row(src, parsed, *program, columns, row);
+      if (!parse(grammar, bound, bound_parsed)) {
+        ++expression_mismatches;
+        continue;
+      }
+      auto expected = evaluator.evaluate(bound_parsed.ast, bound_parsed.tokens);
+      if (const auto *value = std::get_if<i64>(&expected))
+        expression_mismatches +=
+            status[row] != BatchEvaluator::ok || results[row] != *value;
+      else
+        expression_mismatches +=
+            (status[row] & status_of(std::get<EvalError>(expected).kind)) ==
+            0;
+    }
+    mismatches += expression_mismatches;
+
+    std::cout << std::format(
+        "{:>6}{:>8}{:>12.1f}{:>10}{:>12}  {}\n", program->variables.size(),
+        program->code.size(), static_cast<double>(row_count) / best / 1e6,
+        std::count_if(
+            status.begin(), status.end(),
+            [](u8 row_status) {
+              return row_status != BatchEvaluator::ok;
+            }
+        ),
+        expression_mismatches, src
+    );
+  }
+  std::cout << std::format("{} mismatches\n", mismatches);
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
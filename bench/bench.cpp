@@ -0,0 +1,270 @@
+// Benchmark suite timing each stage on its own: lexing, the grammar
+// pipeline from `Grammar::from_str` to `build_prediction_table`, and
+// parsing in every mode from the plain recognizer to the full trace. The
+// inputs are generated from a seed, so runs are comparable across builds.
+// Each measurement is the fastest of `--rounds` runs, printed as CSV
+// (default) or JSON, one record per metric.
+//
+// The grammar pipeline runs on the expression grammar, or on the grammar
+// in `--grammar FILE`, such as one made by grammar_gen; its start symbol is
+// the lhs of the first line.
+//
+//   bench [--format csv|json] [--seed N] [--lines N] [--terms N]
+//         [--depth N] [--error-rate P] [--rounds N] [--grammar FILE]
+
+#include "parser/parser.h"
+#include "simple_lexer/lexer.h"
+#include "util/mapped_file.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+struct Options {
+  bool json = false;
+  u64 seed = 1;
+  usize lines = 20000;
+  usize rounds = 3;
+  bench::ExpressionShape shape{};
+  const char *grammar_path = nullptr;
+};
+
+struct Record {
+  std::string stage;
+  std::string name;
+  std::string metric;
+  double value;
+  std::string unit;
+};
+
+// Fastest of `rounds` runs of `f`, in seconds.
+template<class F>
+double best_seconds(usize rounds, F &&f) {
+  double best = 1e300;
+  for (usize i = 0; i < rounds; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(
+        best, std::chrono::duration<double>(
+                  std::chrono::steady_clock::now() - start
+              )
+                  .count()
+    );
+  }
+  return best;
+}
+
+void bench_lexer(
+    const Options &options, std::string_view name, std::string_view src,
+    std::vector<Record> &records
+) {
+  usize tokens = 0;
+  auto seconds = best_seconds(options.rounds, [&] {
+    tokens = 0;
+    Lexer lexer(src);
+    while (lexer.next_token())
+      ++tokens;
+  });
+  auto size = static_cast<double>(src.size());
+  records.push_back({"lex", std::string(name), "throughput",
+                     size / seconds / 1e6, "MB/s"});
+  records.push_back({"lex", std::string(name), "tokens",
+                     static_cast<double>(tokens) / seconds / 1e6, "M/s"});
+}
+
+void bench_grammar(
+    const Options &options, const std::string &source,
+    std::vector<Record> &records
+) {
+  // Enough repetitions of a small grammar to time each stage in
+  // microseconds.
+  usize repetitions = std::max<usize>(1, 100000 / (source.size() + 1));
+  usize productions = 0, conflict_count = 0;
+  double stages[7]{};
+  for (usize round = 0; round < options.rounds; ++round) {
+    double totals[7]{};
+    for (usize i = 0; i < repetitions; ++i) {
+      auto lap = std::chrono::steady_clock::now();
+      auto next = [&](double &total) {
+        auto now = std::chrono::steady_clock::now();
+        total += std::chrono::duration<double>(now - lap).count();
+        lap = now;
+      };
+
+      auto grammar = Grammar::from_str(source);
+      next(totals[0]);
+      grammar.eliminate_left_recursion();
+      next(totals[1]);
+      grammar.extract_left_factoring();
+      next(totals[2]);
+      auto first_set = grammar.build_first_set();
+      next(totals[3]);
+      auto follow_set =
+          grammar.build_follow_set(first_set, {0, Symbol::NonTerminator});
+      next(totals[4]);
+      auto conflicts = grammar.find_conflicts(first_set, follow_set);
+      next(totals[5]);
+      auto table = grammar.build_prediction_table(first_set, follow_set);
+      next(totals[6]);
+      productions = table.productions.size();
+      conflict_count = conflicts.size();
+    }
+    for (usize s = 0; s < std::size(stages); ++s)
+      stages[s] = round == 0 ? totals[s] : std::min(stages[s], totals[s]);
+  }
+
+  constexpr std::string_view names[] = {
+      "from_str",  "eliminate_left_recursion", "extract_left_factoring",
+      "first_set", "follow_set",               "find_conflicts",
+      "prediction_table"
+  };
+  double total = 0;
+  for (usize s = 0; s < std::size(stages); ++s) {
+    total += stages[s];
+    records.push_back({"grammar", std::string(names[s]), "time",
+                       stages[s] / repetitions * 1e6, "us"});
+  }
+  records.push_back({"grammar", "total", "time", total / repetitions * 1e6,
+                     "us"});
+  records.push_back({"grammar", "productions", "count",
+                     static_cast<double>(productions), ""});
+  records.push_back({"grammar", "conflicts", "count",
+                     static_cast<double>(conflict_count), ""});
+}
+
+void bench_parse(
+    const Options &options, const CompiledGrammar &grammar,
+    std::string_view src, std::vector<Record> &records
+) {
+  constexpr std::pair<std::string_view, ParseMode> modes[] = {
+      {"recognize",  ParseMode::Recognize },
+      {"derivation", ParseMode::Derivation},
+      {"ast",        ParseMode::Ast       },
+      {"eval",       ParseMode::Evaluate  },
+      {"compile",    ParseMode::Compile   },
+      {"trace",      ParseMode::Trace     },
+  };
+
+  for (const auto &[name, mode] : modes) {
+    ParseSession session(grammar);
+    session.set_mode(mode);
+    std::string out;
+    usize tokens = 0, lines = 0, accepted = 0;
+    auto seconds = best_seconds(options.rounds, [&] {
+      tokens = lines = accepted = 0;
+      LineReader reader(src);
+      for (std::optional<std::string_view> line; (line = reader.next_line());) {
+        out.clear();
+        accepted += session.run(*line, out);
+        tokens += session.token_stream().size();
+        ++lines;
+      }
+    });
+    records.push_back({"parse", std::string(name), "tokens",
+                       static_cast<double>(tokens) / seconds / 1e6, "M/s"});
+    records.push_back({"parse", std::string(name), "lines",
+                       static_cast<double>(lines) / seconds / 1e3, "k/s"});
+    records.push_back({"parse", std::string(name), "accepted",
+                       static_cast<double>(accepted), "lines"});
+  }
+}
+
+void print_csv(const std::vector<Record> &records) {
+  std::cout << "stage,name,metric,value,unit\n";
+  for (const auto &[stage, name, metric, value, unit] : records)
+    std::cout << std::format(
+        "{},{},{},{:.4f},{}\n", stage, name, metric, value, unit
+    );
+}
+
+void print_json(const Options &options, const std::vector<Record> &records) {
+  std::cout << std::format(
+      "{{\n  \"seed\": {},\n  \"lines\": {},\n  \"terms\": {},\n"
+      "  \"depth\": {},\n  \"error_rate\": {},\n  \"rounds\": {},\n"
+      "  \"grammar\": \"{}\",\n  \"results\": [\n",
+      options.seed, options.lines, options.shape.terms, options.shape.depth,
+      options.shape.error_rate, options.rounds,
+      options.grammar_path ? options.grammar_path : "expression"
+  );
+  for (usize i = 0; i < records.size(); ++i) {
+    const auto &[stage, name, metric, value, unit] = records[i];
+    std::cout << std::format(
+        "    {{\"stage\": \"{}\", \"name\": \"{}\", \"metric\": \"{}\", "
+        "\"value\": {:.4f}, \"unit\": \"{}\"}}{}\n",
+        stage, name, metric, value, unit, i + 1 < records.size() ? "," : ""
+    );
+  }
+  std::cout << "  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--format" && has_value)
+      options.json = std::string_view(argv[++i]) == "json";
+    else if (arg == "--seed" && has_value)
+      options.seed = std::stoull(argv[++i]);
+    else if (arg == "--lines" && has_value)
+      options.lines = std::stoul(argv[++i]);
+    else if (arg == "--terms" && has_value)
+      options.shape.terms = std::max<usize>(1, std::stoul(argv[++i]));
+    else if (arg == "--depth" && has_value)
+      options.shape.depth = std::stoul(argv[++i]);
+    else if (arg == "--error-rate" && has_value)
+      options.shape.error_rate = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+    else if (arg == "--rounds" && has_value)
+      options.rounds = std::max<usize>(1, std::stoul(argv[++i]));
+    else if (arg == "--grammar" && has_value)
+      options.grammar_path = argv[++i];
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--format csv|json] [--seed N] [--lines N] [--terms N]"
+                << " [--depth N] [--error-rate P] [--rounds N]"
+                << " [--grammar FILE]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::string grammar_source(bench::expression_grammar);
+  if (options.grammar_path) {
+    try {
+      grammar_source = bench::read_grammar_file(options.grammar_path);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto dense_shape = options.shape, spaced_shape = options.shape;
+  spaced_shape.spaced = true;
+  auto dense = bench::ExpressionGenerator(dense_shape, options.seed)
+                   .lines(options.lines);
+  auto spaced = bench::ExpressionGenerator(spaced_shape, options.seed)
+                    .lines(options.lines);
+
+  std::vector<Record> records;
+  bench_lexer(options, "dense", dense, records);
+  bench_lexer(options, "spaced", spaced, records);
+  bench_grammar(options, grammar_source, records);
+  CompiledGrammar grammar(static_grammar<bench::expression_grammar>);
+  bench_parse(options, grammar, dense, records);
+
+  if (options.json)
+    print_json(options, records);
+  else
+    print_csv(records);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+// Parsing time per symbol of the table-driven `ll1_parse` against the
+// recursive-descent parser that parser_gen generates for the same grammar,
+// both recognizing and recording the derivation. `ll1_parse` runs on the
+// heap copy of the table in `CompiledGrammar` and on the `static_grammar`
+// arrays themselves. The derivations of the three are checked to be equal.
+// Each of `rounds` runs parses every expression once and the fastest run is
+// reported.
+//
+//   codegen_bench [expressions] [seed]
+
+#include "expr_parser.h"
+#include "parser/parser.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+template<class F>
+double best_ns(int rounds, F &&f) {
+  double best = 1e300;
+  for (int i = 0; i < rounds; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(
+        best, std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start
+              )
+                  .count()
+    );
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  usize count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  u64 seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+  constexpr int rounds = 5;
+
+  constexpr const auto &static_table =
+      static_grammar<bench::expression_grammar>;
+  CompiledGrammar grammar(static_table);
+  for (u32 i = 0; i < std::size(expr::terminal_names); ++i)
+    if (grammar.symbols().to_string({i, Symbol::Terminator}) !=
+        expr::terminal_names[i]) {
+      std::cerr << "expr_parser.h is out of date" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+  // Expressions one after the other, each ending in `$`; one in ten has a
+  // syntax error.
+  bench::ExpressionGenerator generator({.error_rate = 0.1}, seed);
+  std::vector<Symbol> symbols;
+  std::vector<usize> starts;
+  for (usize i = 0; i < count; ++i) {
+    std::string src;
+    generator.append_expression(src);
+    std::vector<Token> tokens;
+    Lexer lexer(src);
+    for (std::optional<Token> token; (token = lexer.next_token());)
+      tokens.push_back(*token);
+    auto stream = grammar.convert_lexeme_to_symbol(tokens);
+    starts.push_back(symbols.size());
+    symbols.insert(symbols.end(), stream.begin(), stream.end());
+    symbols.push_back(Symbol::end_symbol());
+  }
+  starts.push_back(symbols.size());
+  std::vector<expr::Terminal> terminals;
+  for (auto symbol : symbols)
+    terminals.push_back(static_cast<expr::Terminal>(symbol.id));
+
+  auto expression = [&](const auto &stream, usize i) {
+    return std::span(stream).subspan(starts[i], starts[i + 1] - starts[i]);
+  };
+
+  usize accepted = 0, mismatches = 0;
+  std::vector<Symbol> stack;
+  Derivation table_derivation, static_derivation;
+  std::vector<u32> generated_steps;
+  for (usize i = 0; i < count; ++i) {
+    table_derivation.steps.clear();
+    table_derivation.accepted = ll1_parse(
+        grammar.prediction_table(), grammar.start_symbol(),
+        expression(symbols, i), stack,
+        DerivationRecorder{table_derivation.steps}
+    );
+    static_derivation.steps.clear();
+    static_derivation.accepted = ll1_parse(
+        static_table, static_table.start_symbol, expression(symbols, i),
+        stack, DerivationRecorder{static_derivation.steps}
+    );
+    generated_steps.clear();
+    bool generated_accepted =
+        expr::parse(expression(terminals, i), [&](u32 production) {
+          generated_steps.push_back(production);
+        });
+    accepted += generated_accepted;
+    // Past an error the table driver skips input and goes on, so only the
+    // derivations of accepted input are comparable.
+    mismatches += static_derivation.accepted != table_derivation.accepted ||
+                  static_derivation.steps != table_derivation.steps ||
+                  generated_accepted != table_derivation.accepted ||
+                  (generated_accepted &&
+                   generated_steps != table_derivation.steps);
+  }
+
+  usize sink = 0;
+  auto table_recognize = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i)
+      sink += ll1_parse(
+          grammar.prediction_table(), grammar.start_symbol(),
+          expression(symbols, i), stack, Recognizer{}
+      );
+  });
+  auto static_recognize = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i)
+      sink += ll1_parse(
+          static_table, static_table.start_symbol, expression(symbols, i),
+          stack, Recognizer{}
+      );
+  });
+  auto generated_recognize = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i)
+      sink += expr::recognize(expression(terminals, i));
+  });
+  auto table_derive = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i) {
+      table_derivation.steps.clear();
+      sink += ll1_parse(
+          grammar.prediction_table(), grammar.start_symbol(),
+          expression(symbols, i), stack,
+          DerivationRecorder{table_derivation.steps}
+      );
+    }
+  });
+  auto static_derive = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i) {
+      static_derivation.steps.clear();
+      sink += ll1_parse(
+          static_table, static_table.start_symbol, expression(symbols, i),
+          stack, DerivationRecorder{static_derivation.steps}
+      );
+    }
+  });
+  auto generated_derive = best_ns(rounds, [&] {
+    for (usize i = 0; i < count; ++i) {
+      generated_steps.clear();
+      sink += expr::parse(expression(terminals, i), [&](u32 production) {
+        generated_steps.push_back(production);
+      });
+    }
+  });
+
+  auto per_symbol = [&](double ns) {
+    return ns / static_cast<double>(symbols.size());
+  };
+  std::cout << std::format(
+      "{} expressions, {} symbols, {} accepted, {} mismatches\n", count,
+      symbols.size(), accepted, mismatches
+  );
+  std::cout << std::format(
+      "{:<12}{:>16}{:>16}{:>16}\n", "", "table ns/sym", "static ns/sym",
+      "codegen ns/sym"
+  );
+  std::cout << std::format(
+      "{:<12}{:>16.2f}{:>16.2f}{:>16.2f}\n", "recognize",
+      per_symbol(table_recognize), per_symbol(static_recognize),
+      per_symbol(generated_recognize)
+  );
+  std::cout << std::format(
+      "{:<12}{:>16.2f}{:>16.2f}{:>16.2f}\n", "derive",
+      per_symbol(table_derive), per_symbol(static_derive),
+      per_symbol(generated_derive)
+  );
+
+  return sink == 0 || mismatches != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
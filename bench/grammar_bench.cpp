@@ -0,0 +1,112 @@
+// Time to build FIRST, FOLLOW and the prediction table of generated
+// grammars with many nonterminators, and to list their LL(1) conflicts. The
+// grammars are random, not LL(1); each nonterminator has a few alternatives
+// drawing on later nonterminators mostly, with some back edges to make large
+// cycles, and on ε.
+//
+//   grammar_bench [seed]
+
+#include "parser/grammar.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace ep;
+
+namespace {
+
+Grammar generate(usize nonterminator_count, usize terminator_count, u64 seed) {
+  std::mt19937_64 rng(seed);
+  Grammar grammar{};
+
+  std::vector<Symbol> nonterminators, terminators;
+  for (usize i = 0; i < nonterminator_count; ++i)
+    nonterminators.push_back(grammar.symbols.intern(
+        std::format("N{}", i), Symbol::NonTerminator
+    ));
+  for (usize i = 0; i < terminator_count; ++i)
+    terminators.push_back(
+        grammar.symbols.intern(std::format("t{}", i), Symbol::Terminator)
+    );
+
+  std::uniform_int_distribution<usize> alternatives(1, 4), length(1, 6);
+  std::uniform_int_distribution<usize> terminator(0, terminator_count - 1);
+  std::uniform_int_distribution<usize> percent(0, 99);
+  for (usize i = 0; i < nonterminator_count; ++i) {
+    for (usize a = alternatives(rng); a > 0; --a) {
+      std::vector<Symbol> rhs;
+      if (percent(rng) < 10) {
+        rhs.push_back(Symbol::empty_symbol());
+      } else {
+        for (usize k = length(rng); k > 0; --k) {
+          auto roll = percent(rng);
+          if (roll < 40) {
+            rhs.push_back(terminators[terminator(rng)]);
+          } else {
+            // Forward edges keep most chains long; 10% point anywhere.
+            auto lo = roll < 50 ? 0 : i;
+            std::uniform_int_distribution<usize> target(
+                lo, nonterminator_count - 1
+            );
+            rhs.push_back(nonterminators[target(rng)]);
+          }
+        }
+      }
+      grammar.push_production(nonterminators[i], std::move(rhs));
+    }
+  }
+  return grammar;
+}
+
+template<class F>
+double time_ms(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start
+  )
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  u64 seed = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+
+  std::cout << std::format(
+      "{:>16}{:>14}{:>14}{:>14}{:>14}{:>12}\n", "nonterminators", "FIRST ms",
+      "FOLLOW ms", "table ms", "LL(1) ms", "conflicts"
+  );
+  for (usize nonterminator_count : {250, 1000, 4000, 16000}) {
+    auto grammar = generate(nonterminator_count, 64, seed);
+    auto start_symbol = *grammar.symbols.find("N0");
+
+    FirstSet first_set;
+    FollowSet follow_set;
+    PredictionTable table;
+    auto first_ms = time_ms([&] {
+      first_set = grammar.build_first_set();
+    });
+    auto follow_ms = time_ms([&] {
+      follow_set = grammar.build_follow_set(first_set, start_symbol);
+    });
+    auto table_ms = time_ms([&] {
+      table = grammar.build_prediction_table(first_set, follow_set);
+    });
+    std::vector<LL1Conflict> conflicts;
+    auto ll1_ms = time_ms([&] {
+      conflicts = grammar.find_conflicts(first_set, follow_set);
+    });
+    std::cout << std::format(
+        "{:>16}{:>14.2f}{:>14.2f}{:>14.2f}{:>14.2f}{:>12}\n",
+        nonterminator_count, first_ms, follow_ms, table_ms, ll1_ms,
+        conflicts.size()
+    );
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+// Latency of an edit to one long expression with `IncrementalParser`,
+// against lexing and parsing the edited line from scratch, for lines of
+// growing length. Two kinds of edits: changing a digit, which keeps the
+// expression valid, and inserting or deleting a few random characters,
+// which mostly breaks it. Every incremental verdict and error offset is
+// checked against a `StreamParser` fed the whole line.
+//
+//   incremental_bench [edits] [seed]
+
+#include "parser/incremental_parser.h"
+#include "parser/stream_parser.h"
+#include "workload.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+struct Edit {
+  usize offset;
+  usize removed;
+  std::string inserted;
+};
+
+// A line of about `size` bytes: random expressions joined by `+`.
+std::string make_line(usize size, u64 seed) {
+  bench::ExpressionGenerator generator({.spaced = true}, seed);
+  std::string line;
+  while (line.size() < size) {
+    if (!line.empty())
+      line.append(" + ");
+    generator.append_expression(line);
+  }
+  return line;
+}
+
+// `count` edits applied one after the other to `line`, which is left as
+// after the last one.
+std::vector<Edit>
+make_edits(std::string &line, usize count, bool random, u64 seed) {
+  static constexpr std::string_view pieces[] = {"+", "(", ")", "1", " ",
+                                                "x+", "", "*2"};
+  std::mt19937_64 rng(seed);
+  std::vector<Edit> edits;
+  while (edits.size() < count) {
+    Edit edit;
+    if (random) {
+      edit.offset = std::uniform_int_distribution<usize>(0, line.size())(rng);
+      edit.removed = std::min<usize>(
+          line.size() - edit.offset,
+          std::uniform_int_distribution<usize>(0, 2)(rng)
+      );
+      edit.inserted = pieces[std::uniform_int_distribution<usize>(
+          0, std::size(pieces) - 1
+      )(rng)];
+    } else {
+      auto at = std::uniform_int_distribution<usize>(0, line.size() - 1)(rng);
+      if (line[at] < '0' || line[at] > '9')
+        continue;
+      edit = {at, 1, std::string(1, static_cast<char>('0' + rng() % 10))};
+    }
+    line.replace(edit.offset, edit.removed, edit.inserted);
+    edits.push_back(std::move(edit));
+  }
+  return edits;
+}
+
+template<class F>
+double elapsed_us(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start
+  )
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  usize count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+  u64 seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+  CompiledGrammar grammar(static_grammar<bench::expression_grammar>);
+  IncrementalParser incremental(grammar), scratch(grammar);
+  StreamParser reference(grammar);
+
+  std::cout << std::format(
+      "{:>8} {:<8}{:>14}{:>14}{:>10}{:>10}{:>10}\n", "bytes", "edits",
+      "incr us/edit", "full us/edit", "relexed", "reparsed", "accepted"
+  );
+  usize mismatches = 0;
+  for (usize size : {100, 1000, 10000, 100000}) {
+    for (bool random : {false, true}) {
+      auto line = make_line(size, seed);
+      auto edited = line;
+      auto edits = make_edits(edited, count, random, seed);
+
+      // Check every step first, then time the same edits without checks.
+      incremental.reset(line);
+      usize relexed = 0, reparsed = 0, accepted = 0;
+      for (const auto &[offset, removed, inserted] : edits) {
+        auto status = incremental.edit(offset, removed, inserted);
+        relexed += incremental.relexed();
+        reparsed += incremental.reparsed();
+        accepted += status == IncrementalParser::Status::Accepted;
+        reference.reset();
+        reference.feed(incremental.source());
+        bool reference_accepted =
+            reference.finish() == StreamParser::Status::Accepted;
+        mismatches +=
+            reference_accepted !=
+                (status == IncrementalParser::Status::Accepted) ||
+            (!reference_accepted &&
+             reference.error_offset() != incremental.error_offset());
+      }
+      if (incremental.source() != edited)
+        ++mismatches;
+
+      incremental.reset(line);
+      auto incremental_us = elapsed_us([&] {
+        for (const auto &[offset, removed, inserted] : edits)
+          incremental.edit(offset, removed, inserted);
+      });
+      auto full_us = elapsed_us([&] {
+        std::string src = line;
+        for (const auto &[offset, removed, inserted] : edits) {
+          src.replace(offset, removed, inserted);
+          scratch.reset(src);
+        }
+      });
+
+      auto per_edit = [&](double total) {
+        return total / static_cast<double>(edits.size());
+      };
+      std::cout << std::format(
+          "{:>8} {:<8}{:>14.2f}{:>14.2f}{:>10.1f}{:>10.1f}{:>10}\n",
+          line.size(), random ? "random" : "digit", per_edit(incremental_us),
+          per_edit(full_us), per_edit(static_cast<double>(relexed)),
+          per_edit(static_cast<double>(reparsed)), accepted
+      );
+    }
+  }
+  std::cout << std::format("{} mismatches\n", mismatches);
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
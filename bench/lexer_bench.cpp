@@ -0,0 +1,120 @@
+// Lexing throughput, in bytes per cycle, over a few generated inputs. Each
+// input is lexed `rounds` times and the fastest round is reported.
+//
+//   lexer_bench [size in bytes] [seed]
+
+#include "simple_lexer/lexer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+#endif
+
+using namespace ep;
+
+namespace {
+
+// Time stamp counter ticks where available, nanoseconds elsewhere.
+inline u64 now() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()
+  )
+      .count();
+#endif
+}
+
+std::string long_numbers(usize size, std::mt19937_64 &rng) {
+  std::string src;
+  std::uniform_int_distribution<int> digit('0', '9');
+  while (src.size() < size) {
+    for (int i = 0; i < 18; ++i)
+      src.push_back(static_cast<char>(digit(rng)));
+    src.push_back('+');
+  }
+  return src;
+}
+
+std::string wide_spacing(usize size, std::mt19937_64 &rng) {
+  std::string src;
+  std::uniform_int_distribution<int> run(8, 64);
+  while (src.size() < size) {
+    src.append(static_cast<usize>(run(rng)), ' ');
+    src.append("x * ( 1 - y )");
+    src.append(static_cast<usize>(run(rng)) / 8, '\t');
+  }
+  return src;
+}
+
+std::string expressions(usize size, std::mt19937_64 &rng) {
+  static constexpr std::string_view atoms[] = {"1", "42", "x", "count_2",
+                                               "(", ")", "7"};
+  static constexpr std::string_view ops[] = {"+", "-", "*", "/", " + ", " * "};
+  std::string src;
+  std::uniform_int_distribution<usize> atom(0, std::size(atoms) - 1);
+  std::uniform_int_distribution<usize> op(0, std::size(ops) - 1);
+  while (src.size() < size) {
+    src.append(atoms[atom(rng)]);
+    src.append(ops[op(rng)]);
+  }
+  return src;
+}
+
+// Lexes `src` to the end; returns the number of tokens, so that the work
+// cannot be optimized away.
+usize lex(std::string_view src) {
+  usize tokens = 0;
+  Lexer lexer(src);
+  while (lexer.next_token())
+    ++tokens;
+  return tokens;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  usize size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+  u64 seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+  constexpr int rounds = 5;
+
+  std::mt19937_64 rng(seed);
+  const std::pair<std::string_view, std::string> inputs[] = {
+      {"long_numbers", long_numbers(size, rng)},
+      {"wide_spacing", wide_spacing(size, rng)},
+      {"expressions", expressions(size, rng)},
+  };
+
+#if defined(__x86_64__) || defined(__i386__)
+  constexpr std::string_view unit = "cycle";
+#else
+  constexpr std::string_view unit = "ns";
+#endif
+  std::cout << std::format(
+      "{:<14}{:>12}{:>12}{:>16}\n", "input", "bytes", "tokens",
+      std::format("bytes/{}", unit)
+  );
+  for (const auto &[name, src] : inputs) {
+    u64 best = ~u64{};
+    usize tokens = 0;
+    for (int i = 0; i < rounds; ++i) {
+      auto start = now();
+      tokens = lex(src);
+      best = std::min(best, now() - start);
+    }
+    std::cout << std::format(
+        "{:<14}{:>12}{:>12}{:>16.3f}\n", name, src.size(), tokens,
+        static_cast<double>(src.size()) / static_cast<double>(best)
+    );
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+// Memory use and lookup speed of `CompressedTable` against the dense
+// `PredictionTable` it is built from, for the expression grammar and each
+// grammar file given, such as one made by grammar_gen; the start symbol of
+// a file is the lhs of its first line. Every cell of each compressed table
+// is checked against the dense one. Lookups are timed on random cells, and
+// on random nonempty cells, which are the ones a parse reads.
+//
+//   table_bench [--lookups N] [--seed N] [FILE...]
+
+#include "parser/compressed_table.h"
+#include "workload.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+using Cell = std::pair<Symbol, Symbol>;
+
+template<class F>
+double elapsed_ms(F &&f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start
+  )
+      .count();
+}
+
+template<class Table>
+double ns_per_lookup(const Table &table, const std::vector<Cell> &cells) {
+  u64 sum = 0;
+  auto ms = elapsed_ms([&] {
+    for (const auto &[nonterminator, terminator] : cells)
+      sum += table.lookup(nonterminator, terminator);
+  });
+  // Keeps the lookups from being optimized away.
+  if (sum == 1)
+    std::cerr << "";
+  return ms * 1e6 / static_cast<double>(cells.size());
+}
+
+bool same_cells(const PredictionTable &dense, const CompressedTable &table) {
+  for (u32 n = 0; n < dense.nonterminator_count; ++n)
+    for (u32 t = 0; t < dense.terminator_count; ++t) {
+      Symbol nonterminator{n, Symbol::NonTerminator};
+      Symbol terminator{t, Symbol::Terminator};
+      if (dense.lookup(nonterminator, terminator) !=
+              table.lookup(nonterminator, terminator) ||
+          dense.synchronizes(nonterminator, terminator) !=
+              table.synchronizes(nonterminator, terminator))
+        return false;
+    }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  usize lookups = 1 << 22;
+  u64 seed = 1;
+  std::vector<std::pair<std::string, std::string>> sources{
+      {"expression", std::string(bench::expression_grammar)}
+  };
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--lookups") == 0 && i + 1 < argc) {
+      lookups = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      try {
+        sources.emplace_back(argv[i], bench::read_grammar_file(argv[i]));
+      } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  std::cout << std::format(
+      "{:<16}{:>7}{:>7}{:>8}{:>12}{:>12}{:>8}{:>10}{:>10}{:>10}{:>10}\n",
+      "grammar", "terms", "nonts", "classes", "dense KiB", "packed KiB",
+      "fill %", "build ms", "ns dense", "ns packed", "hits"
+  );
+  usize mismatches = 0;
+  for (const auto &[name, source] : sources) {
+    auto grammar = Grammar::from_str(source);
+    grammar.eliminate_left_recursion();
+    grammar.extract_left_factoring();
+    auto dense = grammar.build_prediction_table({0, Symbol::NonTerminator});
+
+    CompressedTable table;
+    auto build_ms = elapsed_ms([&] {
+      table = CompressedTable(dense);
+    });
+    mismatches += !same_cells(dense, table);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<u32> nonterminator(
+        0, static_cast<u32>(dense.nonterminator_count - 1)
+    );
+    std::uniform_int_distribution<u32> terminator(
+        0, static_cast<u32>(dense.terminator_count - 1)
+    );
+    std::vector<Cell> random_cells(lookups), nonempty_cells{};
+    for (auto &cell : random_cells)
+      cell = {
+          {nonterminator(rng), Symbol::NonTerminator},
+          {terminator(rng),    Symbol::Terminator   }
+      };
+    std::vector<Cell> filled{};
+    for (u32 n = 0; n < dense.nonterminator_count; ++n)
+      for (u32 t = 0; t < dense.terminator_count; ++t)
+        if (dense.lookup({n, Symbol::NonTerminator}, {t, Symbol::Terminator}) !=
+            PredictionTable::no_entry)
+          filled.push_back(
+              {{n, Symbol::NonTerminator}, {t, Symbol::Terminator}}
+          );
+    std::uniform_int_distribution<usize> pick(0, filled.size() - 1);
+    nonempty_cells.resize(lookups);
+    for (auto &cell : nonempty_cells)
+      cell = filled[pick(rng)];
+
+    auto dense_bytes = (dense.cells.size() * sizeof(u32) + dense.follow.size());
+    auto fill = 100.0 * static_cast<double>(table.used_slot_count()) /
+                static_cast<double>(table.slot_count());
+    for (const auto *cells : {&random_cells, &nonempty_cells})
+      std::cout << std::format(
+          "{:<16}{:>7}{:>7}{:>8}{:>12.1f}{:>12.1f}{:>8.1f}{:>10.2f}{:>10.2f}"
+          "{:>10.2f}{:>10}\n",
+          name.size() > 15 ? "..." + name.substr(name.size() - 12) : name,
+          dense.terminator_count, dense.nonterminator_count,
+          table.class_count(), static_cast<double>(dense_bytes) / 1024,
+          static_cast<double>(table.lookup_bytes()) / 1024, fill, build_ms,
+          ns_per_lookup(dense, *cells), ns_per_lookup(table, *cells),
+          cells == &random_cells ? "random" : "nonempty"
+      );
+  }
+  std::cout << std::format("{} mismatches\n", mismatches);
+  return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef EP_BENCH_WORKLOAD_H
+#  define EP_BENCH_WORKLOAD_H
+
+#  include "util/mapped_file.h"
+#  include "util/type.h"
+
+#  include <cctype>
+#  include <random>
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace ep::bench {
+
+// The expression grammar of `main.cpp` and grammars/expr.grammar.
+inline constexpr std::string_view expression_grammar = R"(E -> E + T | E - T | T
+T -> T * F | T / F | F
+F -> ( E ) | n | id)";
+
+struct ExpressionShape {
+  usize terms = 6;       // Operands per parenthesized level, at most.
+  usize depth = 4;       // Nesting of parentheses, at most.
+  double error_rate = 0; // Share of expressions with a syntax error.
+  bool spaced = false;   // Whether tokens are separated by spaces.
+};
+
+// Seeded generator of random expressions over the tokens of
+// `expression_grammar`. An erroneous expression has one operator or
+// parenthesis inserted between two of its tokens, which breaks either the
+// alternation of operands and operators or the balance of parentheses, so
+// that it is always rejected, never a lex error.
+class ExpressionGenerator {
+  ExpressionShape shape_;
+  std::mt19937_64 rng_;
+  std::vector<std::string_view> tokens_{};
+
+  void append_tokens(usize depth) {
+    static constexpr std::string_view operands[] = {
+        "1", "42", "x", "count_2", "65535"
+    };
+    static constexpr std::string_view operators[] = {"+", "-", "*", "/"};
+    std::uniform_int_distribution<usize> terms(1, shape_.terms);
+    std::uniform_int_distribution<usize> operand(0, std::size(operands) - 1);
+    std::uniform_int_distribution<usize> op(0, std::size(operators) - 1);
+    std::bernoulli_distribution nest(0.2);
+    for (usize i = terms(rng_); i > 0; --i) {
+      if (depth < shape_.depth && nest(rng_)) {
+        tokens_.push_back("(");
+        append_tokens(depth + 1);
+        tokens_.push_back(")");
+      } else {
+        tokens_.push_back(operands[operand(rng_)]);
+      }
+      if (i > 1)
+        tokens_.push_back(operators[op(rng_)]);
+    }
+  }
+
+public:
+  ExpressionGenerator(ExpressionShape shape, u64 seed):
+      shape_(shape), rng_(seed) {}
+
+  // Appends one expression to `src`, without a line break.
+  void append_expression(std::string &src) {
+    static constexpr std::string_view intruders[] = {"+", "*", "(", ")"};
+    tokens_.clear();
+    append_tokens(0);
+    if (std::bernoulli_distribution(shape_.error_rate)(rng_)) {
+      std::uniform_int_distribution<usize> at(0, tokens_.size());
+      std::uniform_int_distribution<usize> intruder(
+          0, std::size(intruders) - 1
+      );
+      tokens_.insert(tokens_.begin() + at(rng_), intruders[intruder(rng_)]);
+    }
+    for (usize i = 0; i < tokens_.size(); ++i) {
+      if (i != 0 && shape_.spaced)
+        src.push_back(' ');
+      src.append(tokens_[i]);
+    }
+  }
+
+  // `count` expressions, one per line.
+  std::string lines(usize count) {
+    std::string src;
+    for (usize i = 0; i < count; ++i) {
+      append_expression(src);
+      src.push_back('\n');
+    }
+    return src;
+  }
+};
+
+// The grammar in the file at `path`, such as one made by grammar_gen,
+// without the trailing blank lines `Grammar::from_str` does not take.
+// Throws like `MappedFile`.
+inline std::string read_grammar_file(const char *path) {
+  std::string source(MappedFile(path).contents());
+  while (!source.empty() && std::isspace(static_cast<u8>(source.back())))
+    source.pop_back();
+  return source;
+}
+
+} // namespace ep::bench
+
+#endif // EP_BENCH_WORKLOAD_H
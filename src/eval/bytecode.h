@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef EP_EVAL_BYTECODE_H
+#  define EP_EVAL_BYTECODE_H
+
+#  include "eval/evaluator.h"
+#  include "parser/parse_tree.h"
+#  include "simple_lexer/token.h"
+#  include "util/type.h"
+
+#  include <span>
+#  include <string>
+#  include <string_view>
+#  include <variant>
+#  include <vector>
+
+namespace ep {
+
+struct Instruction {
+  enum Opcode : u8 { Const, Load, Add, Sub, Mul, Div } opcode{};
+  // Index into `Program::constants` for `Const`, into `Program::variables`
+  // for `Load`; unused otherwise.
+  u32 operand{};
+};
+
+// Stack machine code of one expression.
+struct Program {
+  std::vector<Instruction> code{};
+  std::vector<i64> constants{};
+  std::vector<std::string> variables{};
+  u32 max_depth{};
+};
+
+[[nodiscard]] std::string to_string(const Program &program);
+
+// Lowers an AST built by `build_ast` into a `Program`. Variables are
+// numbered in order of first appearance; `source` is the text the token
+// spans refer to.
+[[nodiscard]] std::variant<Program, EvalError> compile(
+    const Tree &ast, std::span<const Token> tokens, std::string_view source,
+    const ArithOpTable &ops
+);
+
+// Runs a `Program` over many rows of bindings at once, one block of rows per
+// instruction, so that the per-instruction dispatch is amortized and the
+// arithmetic runs as vectorizable loops.
+class BatchEvaluator {
+public:
+  static constexpr usize block_size = 256;
+
+  // Bits of the per-row status.
+  static constexpr u8 ok = 0;
+  static constexpr u8 overflow = 1 << 0;
+  static constexpr u8 divide_by_zero = 1 << 1;
+
+private:
+  std::vector<i64> stack_{};
+  std::vector<u64> flags_{};
+
+public:
+  // `columns[i]` holds the values of `program.variables[i]`, one per row.
+  // Rows with a nonzero status have an unspecified result.
+  void evaluate(
+      const Program &program, std::span<const std::span<const i64>> columns,
+      std::span<i64> results, std::span<u8> status
+  );
+};
+
+} // namespace ep
+
+#endif // EP_EVAL_BYTECODE_H
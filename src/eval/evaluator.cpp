@@ -0,0 +1,97 @@
+#include "eval/evaluator.h"
+
+#include <format>
+#include <iterator>
+#include <limits>
+
+namespace ep {
+
+std::string to_string(const EvalError &error) {
+  std::string buf;
+  append_string(error, buf);
+  return buf;
+}
+
+void append_string(const EvalError &error, std::string &buf) {
+  std::string_view what = "Unsupported token";
+  switch (error.kind) {
+    case EvalError::Overflow:
+      what = "Overflow at token";
+      break;
+    case EvalError::DivideByZero:
+      what = "Division by zero at token";
+      break;
+    case EvalError::Unsupported:
+      break;
+  }
+  std::format_to(std::back_inserter(buf), "{} {}", what, error.position);
+}
+
+ArithOp ArithOpTable::operator[](Symbol terminator) const {
+  if (terminator.type != Symbol::Terminator || terminator.id >= ops_.size())
+    return ArithOp::Unsupported;
+  return ops_[terminator.id];
+}
+
+Evaluator::Evaluator(const SymbolTable &symbols): ops_(symbols) {}
+
+Evaluator::Evaluator(ArithOpTable ops): ops_(std::move(ops)) {}
+
+const ArithOpTable &Evaluator::ops() const {
+  return ops_;
+}
+
+// `build_ast` allocates operands before the node using them, so visiting the
+// arena in index order is a post-order walk.
+EvalResult Evaluator::evaluate(const Tree &ast, std::span<const Token> tokens) {
+  if (ast.root == TreeNode::none)
+    return EvalError{EvalError::Unsupported, 0};
+
+  values_.resize(ast.nodes.size());
+  for (u32 i = 0; i < ast.nodes.size(); ++i) {
+    const auto &[symbol, position, first_child, _] = ast.nodes[i];
+    auto lhs_node = first_child;
+    auto rhs_node = lhs_node == TreeNode::none
+                        ? lhs_node
+                        : ast.nodes[lhs_node].next_sibling;
+    bool binary = rhs_node != TreeNode::none &&
+                  ast.nodes[rhs_node].next_sibling == TreeNode::none;
+
+    auto op = ops_[symbol];
+    if (op == ArithOp::Value && lhs_node == TreeNode::none) {
+      values_[i] = std::get<Integer>(tokens[position]).value;
+      continue;
+    }
+    if (op < ArithOp::Add || !binary)
+      return EvalError{EvalError::Unsupported, position};
+
+    auto lhs = values_[lhs_node], rhs = values_[rhs_node];
+    bool overflow = false;
+    switch (op) {
+      case ArithOp::Add:
+        overflow = __builtin_add_overflow(lhs, rhs, &values_[i]);
+        break;
+      case ArithOp::Sub:
+        overflow = __builtin_sub_overflow(lhs, rhs, &values_[i]);
+        break;
+      case ArithOp::Mul:
+        overflow = __builtin_mul_overflow(lhs, rhs, &values_[i]);
+        break;
+      case ArithOp::Div:
+        if (rhs == 0)
+          return EvalError{EvalError::DivideByZero, position};
+        overflow = lhs == std::numeric_limits<i64>::min() && rhs == -1;
+        if (!overflow)
+          values_[i] = lhs / rhs;
+        break;
+      default:
+        break;
+    }
+    if (overflow)
+      return EvalError{EvalError::Overflow, position};
+  }
+
+  return values_[ast.root];
+}
+
+} // namespace ep
@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef EP_EVAL_EVALUATOR_H
+#  define EP_EVAL_EVALUATOR_H
+
+#  include "parser/grammar.h"
+#  include "parser/parse_tree.h"
+#  include "simple_lexer/token.h"
+#  include "util/type.h"
+
+#  include <span>
+#  include <string>
+#  include <utility>
+#  include <variant>
+#  include <vector>
+
+namespace ep {
+
+struct EvalError {
+  enum Kind { Overflow, DivideByZero, Unsupported } kind;
+  // Input position of the offending token.
+  u32 position{};
+};
+
+using EvalResult = std::variant<i64, EvalError>;
+
+[[nodiscard]] std::string to_string(const EvalError &error);
+
+// Appends `to_string(error)` to `buf`.
+void append_string(const EvalError &error, std::string &buf);
+
+enum class ArithOp : u8 { Unsupported, Value, Variable, Add, Sub, Mul, Div };
+
+// Meaning of each terminator of the expression grammar: `n`, `id` and the
+// four operators.
+class ArithOpTable {
+  std::vector<ArithOp> ops_{};
+
+public:
+  ArithOpTable() = default;
+
+  // `symbols` is a `SymbolTable`, or anything with its `find` and
+  // `terminator_count`, such as a `TableFile`.
+  template<class Symbols>
+  explicit ArithOpTable(const Symbols &symbols):
+      ops_(symbols.terminator_count(), ArithOp::Unsupported) {
+    for (auto [name, op] : {
+             std::pair{"n",  ArithOp::Value   },
+             std::pair{"id", ArithOp::Variable},
+             std::pair{"+",  ArithOp::Add     },
+             std::pair{"-",  ArithOp::Sub     },
+             std::pair{"*",  ArithOp::Mul     },
+             std::pair{"/",  ArithOp::Div     },
+    })
+      if (auto symbol = symbols.find(name); symbol)
+        ops_[symbol->id] = op;
+  }
+
+  [[nodiscard]] ArithOp operator[](Symbol terminator) const;
+};
+
+// Evaluates ASTs built by `build_ast` over 64-bit signed integers, reporting
+// overflow and division by zero instead of invoking undefined behaviour.
+// Variables are not bound here; see `BatchEvaluator` for those.
+class Evaluator {
+  ArithOpTable ops_{};
+  std::vector<i64> values_{};
+
+public:
+  Evaluator() = default;
+
+  explicit Evaluator(const SymbolTable &symbols);
+
+  explicit Evaluator(ArithOpTable ops);
+
+  [[nodiscard]] const ArithOpTable &ops() const;
+
+  // `tokens` are the tokens the positions in `ast` refer to, whitespace
+  // excluded.
+  [[nodiscard]] EvalResult
+  evaluate(const Tree &ast, std::span<const Token> tokens);
+};
+
+} // namespace ep
+
+#endif // EP_EVAL_EVALUATOR_H
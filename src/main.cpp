@@ -1,29 +1,186 @@
+#include "parser/batch.h"
 #include "parser/parser.h"
+#include "parser/stream_parser.h"
+#include "parser/table_file.h"
+#include "util/mapped_file.h"
 
+#include <format>
 #include <iostream>
-#include <random>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 using namespace ep;
 using namespace std::string_view_literals;
 
 constexpr const auto grammar_sv = R"(E -> E + T | E - T | T
 T -> T * F | T / F | F
-F -> ( E ) | n)"sv; // Change here
+F -> ( E ) | n | id)"sv; // Change here
 
-int main() {
-  auto parser = Parser(Grammar::from_str(grammar_sv));
+int main(int argc, char *argv[]) {
+  auto mode = ParseMode::Trace;
+  const char *input_path = nullptr;
+  const char *table_path = nullptr;
+  const char *emit_table_path = nullptr;
+  usize jobs = 0;
+  bool stream = false;
+  bool stats = false;
+  usize error_limit = ErrorLog::default_limit;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--derivation")
+      mode = ParseMode::Derivation;
+    else if (arg == "--recognize")
+      mode = ParseMode::Recognize;
+    else if (arg == "--ast")
+      mode = ParseMode::Ast;
+    else if (arg == "--eval")
+      mode = ParseMode::Evaluate;
+    else if (arg == "--compile")
+      mode = ParseMode::Compile;
+    else if (arg == "--input" && i + 1 < argc)
+      input_path = argv[++i];
+    else if (arg == "--jobs" && i + 1 < argc)
+      jobs = std::stoul(argv[++i]);
+    else if (arg == "--stream")
+      stream = true;
+    else if (arg == "--table" && i + 1 < argc)
+      table_path = argv[++i];
+    else if (arg == "--emit-table" && i + 1 < argc)
+      emit_table_path = argv[++i];
+    else if (arg == "--stats")
+      stats = true;
+    else if (arg == "--max-errors" && i + 1 < argc)
+      error_limit = std::stoul(argv[++i]);
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--derivation | --recognize | --ast | --eval | --compile]"
+                << " [--input FILE [--jobs N] | --stream] [--table FILE]"
+                << " [--stats] [--max-errors N]\n"
+                << "       " << argv[0] << " --emit-table FILE" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Analyzes the grammar once and saves the result for `--table`, going
+  // through the phases of `CompiledGrammar` without printing them.
+  if (emit_table_path) {
+    try {
+      auto grammar = Grammar::from_str(grammar_sv);
+      grammar.eliminate_left_recursion();
+      grammar.extract_left_factoring();
+      auto start_symbol = grammar.symbols.intern("E", Symbol::NonTerminator);
+      auto first_set = grammar.build_first_set();
+      auto follow_set = grammar.build_follow_set(first_set, start_symbol);
+      if (auto conflicts = grammar.is_ll1(first_set, follow_set); conflicts)
+        throw std::runtime_error(
+            std::format("Grammar is not LL(1)\n{}", *conflicts)
+        );
+      write_table_file(
+          emit_table_path, grammar.symbols,
+          grammar.build_prediction_table(first_set, follow_set), start_symbol
+      );
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  // With `--stats`, the grammar phases and the parses are measured and the
+  // metrics written to the standard error as JSON on exit.
+  Metrics metrics;
+  Metrics *stats_metrics = stats ? &metrics : nullptr;
+  auto print_stats = [&] {
+    if (stats)
+      std::cerr << metrics.to_json() << std::flush;
+  };
+
+  // A saved table or batch runs skip the grammar analysis, or at least
+  // printing it.
+  std::optional<Parser> parser_storage;
+  try {
+    if (table_path) {
+      PhaseTimer timer(stats_metrics, "table_load");
+      parser_storage.emplace(TableFile(table_path));
+    } else if (input_path) {
+      parser_storage.emplace(static_grammar<grammar_sv>);
+    } else {
+      parser_storage.emplace(Grammar::from_str(grammar_sv), stats_metrics);
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto &parser = *parser_storage;
+  parser.set_mode(mode);
+  parser.set_metrics(stats_metrics);
+  parser.set_error_limit(error_limit);
+
+  // One expression per line of the file, lexed straight from the mapping and
+  // parsed on all cores (or `--jobs N`) against the one shared grammar.
+  if (input_path) {
+    MappedFile file;
+    try {
+      file = MappedFile(input_path);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+    ThreadPool pool(jobs);
+    parse_batch(
+        parser.grammar(), mode, file.contents(), pool, std::cout, stats_metrics,
+        error_limit
+    );
+    print_stats();
+    return EXIT_SUCCESS;
+  }
+
+  // Recognizes one expression per line of the standard input, read in
+  // fixed-size chunks that lines may straddle. Being incremental, it has no
+  // per-parse counters.
+  if (stream) {
+    StreamParser stream_parser(parser.grammar());
+    auto report = [&] {
+      if (stream_parser.finish() == StreamParser::Status::Accepted)
+        std::cout << "\033[32mAccept\033[0m" << std::endl;
+      else
+        std::cout << std::format(
+                         "\033[31mReject at {}\033[0m",
+                         stream_parser.error_offset()
+                     )
+                  << std::endl;
+      stream_parser.reset();
+    };
+    char buf[4096];
+    bool unterminated = false;
+    while (std::cin.read(buf, sizeof buf) || std::cin.gcount() != 0) {
+      std::string_view chunk(buf, static_cast<usize>(std::cin.gcount()));
+      for (usize end; (end = chunk.find('\n')) != std::string_view::npos;
+           chunk.remove_prefix(end + 1)) {
+        stream_parser.feed(chunk.substr(0, end));
+        report();
+      }
+      stream_parser.feed(chunk);
+      unterminated = !chunk.empty();
+    }
+    if (unterminated)
+      report();
+    print_stats();
+    return EXIT_SUCCESS;
+  }
 
   std::cerr << "Enter a line of expression, or 'q' to quit." << std::endl;
   for (std::string line; std::getline(std::cin, line);) {
     if (line[0] == 'q')
       break;
     try {
-      parser.load_source(std::move(line));
+      parser.load_source(line);
     } catch (const std::exception &e) {
       std::cerr << e.what() << '\n' << std::endl;
-      continue;
     }
   }
 
+  print_stats();
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,72 @@
+#include "parser/batch.h"
+
+#include "util/mapped_file.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+namespace ep {
+
+std::vector<std::string_view>
+split_lines(std::string_view input, usize target_size) {
+  std::vector<std::string_view> chunks;
+  for (usize start = 0; start < input.size();) {
+    auto end = std::min(start + target_size, input.size());
+    if (end < input.size()) {
+      end = input.find('\n', end);
+      end = end == std::string_view::npos ? input.size() : end + 1;
+    }
+    chunks.push_back(input.substr(start, end - start));
+    start = end;
+  }
+  return chunks;
+}
+
+void parse_batch(
+    const CompiledGrammar &grammar, ParseMode mode, std::string_view input,
+    ThreadPool &pool, std::ostream &out, Metrics *metrics, usize error_limit
+) {
+  // Many more chunks than workers, so that stealing can even out the load,
+  // but not so small that the per-chunk overhead shows.
+  constexpr usize min_chunk_size = usize{1} << 16;
+  auto chunks = split_lines(
+      input, std::max(min_chunk_size, input.size() / (pool.size() * 16))
+  );
+
+  std::vector<ParseSession> sessions;
+  std::vector<Metrics> worker_metrics(metrics ? pool.size() : 0);
+  sessions.reserve(pool.size());
+  for (usize i = 0; i < pool.size(); ++i) {
+    auto &session = sessions.emplace_back(grammar);
+    session.set_mode(mode);
+    session.set_error_limit(error_limit);
+    if (metrics)
+      session.set_metrics(&worker_metrics[i]);
+  }
+
+  std::vector<std::string> outputs(chunks.size());
+  for (usize i = 0; i < chunks.size(); ++i) {
+    pool.submit([&, i](usize worker) {
+      auto &session = sessions[worker];
+      auto &output = outputs[i];
+      LineReader lines(chunks[i]);
+      for (std::optional<std::string_view> line; (line = lines.next_line());) {
+        try {
+          session.run(*line, output);
+        } catch (const std::exception &e) {
+          output.append(e.what()).append("\n\n");
+        }
+      }
+    });
+  }
+  pool.wait();
+  for (const auto &m : worker_metrics)
+    metrics->merge(m);
+
+  for (const auto &output : outputs)
+    out.write(output.data(), static_cast<std::streamsize>(output.size()));
+  out.flush();
+}
+
+} // namespace ep
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef EP_PARSER_BATCH_H
+#  define EP_PARSER_BATCH_H
+
+#  include "parser/parser.h"
+#  include "util/thread_pool.h"
+#  include "util/type.h"
+
+#  include <ostream>
+#  include <string_view>
+#  include <vector>
+
+namespace ep {
+
+// Splits `input` into chunks of whole lines of roughly `target_size` bytes.
+[[nodiscard]] std::vector<std::string_view>
+split_lines(std::string_view input, usize target_size);
+
+// Parses every line of `input` as an expression in `mode`, on the workers
+// of `pool`, which share `grammar` with a session each. Chunks of lines are
+// the unit of work; their outputs are buffered and then written to `out` in
+// input order, errors included. The parses of all workers are recorded into
+// `metrics` if given; each gives up past `error_limit` syntax errors.
+void parse_batch(
+    const CompiledGrammar &grammar, ParseMode mode, std::string_view input,
+    ThreadPool &pool, std::ostream &out, Metrics *metrics = nullptr,
+    usize error_limit = ErrorLog::default_limit
+);
+
+} // namespace ep
+
+#endif // EP_PARSER_BATCH_H
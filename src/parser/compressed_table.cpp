@@ -0,0 +1,172 @@
+#include "parser/compressed_table.h"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace ep {
+
+namespace {
+
+inline u32 encode(const PredictionTable &table, usize cell) {
+  auto production = table.cells[cell] == PredictionTable::no_entry
+                        ? CompressedTable::production_mask
+                        : table.cells[cell];
+  return production | (table.follow[cell] ? CompressedTable::follow_bit : 0);
+}
+
+} // namespace
+
+CompressedTable::CompressedTable(const PredictionTable &table):
+    terminator_count_(table.terminator_count),
+    nonterminator_count_(table.nonterminator_count),
+    productions_(table.productions), rhs_pool_(table.rhs_pool) {
+  if (table.productions.size() >= production_mask)
+    throw std::runtime_error("Too many productions to compress the table");
+  const auto terminator_count = terminator_count_;
+  const auto nonterminator_count = nonterminator_count_;
+
+  // Column classes: each column is hashed, in a row-major pass, and put in
+  // the class of the first column with the same hash. A second pass checks
+  // every column against the first of its class and moves those that only
+  // collided into classes of their own.
+  std::vector<u64> hashes(terminator_count, 0xcbf29ce484222325);
+  for (usize n = 0; n < nonterminator_count; ++n)
+    for (usize t = 0; t < terminator_count; ++t) {
+      hashes[t] ^= encode(table, n * terminator_count + t);
+      hashes[t] *= 0x100000001b3;
+    }
+
+  std::unordered_map<u64, u32> class_of_hash{};
+  std::vector<u32> columns{}; // The first column of each class.
+  classes_.resize(terminator_count);
+  for (u32 t = 0; t < terminator_count; ++t) {
+    auto [it, inserted] =
+        class_of_hash.try_emplace(hashes[t], static_cast<u32>(columns.size()));
+    if (inserted)
+      columns.push_back(t);
+    classes_[t] = it->second;
+  }
+  for (usize n = 0; n < nonterminator_count; ++n)
+    for (u32 t = 0; t < terminator_count; ++t) {
+      auto row = n * terminator_count;
+      if (encode(table, row + t) != encode(table, row + columns[classes_[t]])) {
+        classes_[t] = static_cast<u32>(columns.size());
+        columns.push_back(t);
+      }
+    }
+  class_count_ = columns.size();
+
+  // The nonempty cells of each row over the classes, as {class, entry}.
+  std::vector<std::vector<std::pair<u32, u32>>> rows(nonterminator_count);
+  for (usize n = 0; n < nonterminator_count; ++n)
+    for (u32 c = 0; c < class_count_; ++c)
+      if (auto value = encode(table, n * terminator_count + columns[c]);
+          value != production_mask)
+        rows[n].emplace_back(c, value);
+
+  // First fit, fullest rows first: each row goes to the lowest base at
+  // which all its cells land on free slots. Bases are tried 64 at a time,
+  // by intersecting the free bits under each cell of the row.
+  std::vector<u32> order(nonterminator_count);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](u32 lhs, u32 rhs) {
+    return rows[lhs].size() > rows[rhs].size();
+  });
+
+  std::vector<u64> taken{};
+  // The taken bits of the 64 slots from `slot` on.
+  auto taken_at = [&](usize slot) {
+    auto word = slot / 64, shift = slot % 64;
+    u64 low = word < taken.size() ? taken[word] : 0;
+    if (shift == 0)
+      return low;
+    u64 high = word + 1 < taken.size() ? taken[word + 1] : 0;
+    return low >> shift | high << (64 - shift);
+  };
+
+  bases_.assign(nonterminator_count, 0);
+  usize first_free = 0, end = class_count_;
+  for (auto n : order) {
+    const auto &cells = rows[n];
+    if (cells.empty())
+      break;
+
+    auto base = first_free > cells.front().first
+                    ? first_free - cells.front().first
+                    : 0;
+    for (;; base += 64) {
+      auto fits = ~u64{};
+      for (usize i = 0; i < cells.size() && fits != 0; ++i)
+        fits &= ~taken_at(base + cells[i].first);
+      if (fits != 0) {
+        base += static_cast<usize>(std::countr_zero(fits));
+        break;
+      }
+    }
+
+    bases_[n] = static_cast<u32>(base);
+    end = std::max(end, base + class_count_);
+    taken.resize(std::max(taken.size(), (base + cells.back().first) / 64 + 1));
+    for (const auto &[c, _] : cells)
+      taken[(base + c) / 64] |= u64{1} << (base + c) % 64;
+    while (first_free / 64 < taken.size() &&
+           (taken[first_free / 64] >> first_free % 64 & 1) != 0)
+      ++first_free;
+  }
+
+  // Rows without cells keep base 0 and read slots owned by other rows or
+  // by none; either way their cells are empty.
+  slots_.assign(end, {no_row, production_mask});
+  for (u32 n = 0; n < nonterminator_count; ++n)
+    for (const auto &[c, value] : rows[n])
+      slots_[bases_[n] + c] = {n, value};
+}
+
+usize CompressedTable::terminator_count() const {
+  return terminator_count_;
+}
+
+usize CompressedTable::nonterminator_count() const {
+  return nonterminator_count_;
+}
+
+usize CompressedTable::class_count() const {
+  return class_count_;
+}
+
+usize CompressedTable::slot_count() const {
+  return slots_.size();
+}
+
+usize CompressedTable::used_slot_count() const {
+  return static_cast<usize>(
+      std::count_if(slots_.begin(), slots_.end(), [](const Slot &slot) {
+        return slot.row != no_row;
+      })
+  );
+}
+
+usize CompressedTable::lookup_bytes() const {
+  return classes_.size() * sizeof(u32) + bases_.size() * sizeof(u32) +
+         slots_.size() * sizeof(Slot);
+}
+
+PredictionTable CompressedTable::prediction_table() const {
+  PredictionTable table{terminator_count_, nonterminator_count_};
+  for (u32 n = 0; n < nonterminator_count_; ++n)
+    for (u32 t = 0; t < terminator_count_; ++t) {
+      Symbol nonterminator{n, Symbol::NonTerminator};
+      Symbol terminator{t, Symbol::Terminator};
+      table.at(nonterminator, terminator) = lookup(nonterminator, terminator);
+      table.follow[n * terminator_count_ + t] =
+          synchronizes(nonterminator, terminator);
+    }
+  table.productions = productions_;
+  table.rhs_pool = rhs_pool_;
+  return table;
+}
+
+} // namespace ep
@@ -0,0 +1,93 @@
+#pragma once
+
+#ifndef EP_PARSER_COMPRESSED_TABLE_H
+#  define EP_PARSER_COMPRESSED_TABLE_H
+
+#  include "parser/grammar.h"
+#  include "util/type.h"
+
+#  include <span>
+#  include <vector>
+
+namespace ep {
+
+// Prediction table compressed for large sparse grammars, with the lookup
+// interface of `PredictionTable`. Terminators whose columns are equal,
+// FOLLOW flags included, share a column class. The rows, reduced to their
+// nonempty cells over the classes, are then packed into one comb vector by
+// row displacement: row `n` keeps class `c` in slot `base[n] + c`, and
+// rows are fitted into each other's gaps. Every slot records the row owning
+// it, so a lookup is two loads and a check whatever the size of the table.
+class CompressedTable {
+public:
+  struct Slot {
+    u32 row{};
+    // A production index, with `follow_bit` set if the cell synchronizes.
+    u32 entry{};
+  };
+
+  static constexpr u32 no_row = ~u32{};
+  static constexpr u32 follow_bit = u32{1} << 31;
+  static constexpr u32 production_mask = follow_bit - 1;
+
+private:
+  usize terminator_count_{};
+  usize nonterminator_count_{};
+  usize class_count_{};
+  std::vector<u32> classes_{};
+  std::vector<u32> bases_{};
+  std::vector<Slot> slots_{};
+  std::vector<Production> productions_{};
+  std::vector<Symbol> rhs_pool_{};
+
+  // The entry of a cell, `production_mask` alone if it is empty.
+  [[nodiscard]] u32 entry(Symbol nonterminator, Symbol terminator) const {
+    const auto &slot =
+        slots_[bases_[nonterminator.id] + classes_[terminator.id]];
+    return slot.row == nonterminator.id ? slot.entry : production_mask;
+  }
+
+public:
+  CompressedTable() = default;
+
+  // Throws `std::runtime_error` if the table has too many productions for
+  // an entry.
+  explicit CompressedTable(const PredictionTable &table);
+
+  [[nodiscard]] u32 lookup(Symbol nonterminator, Symbol terminator) const {
+    auto production = entry(nonterminator, terminator) & production_mask;
+    return production == production_mask ? PredictionTable::no_entry
+                                         : production;
+  }
+
+  [[nodiscard]] bool
+  synchronizes(Symbol nonterminator, Symbol terminator) const {
+    return (entry(nonterminator, terminator) & follow_bit) != 0;
+  }
+
+  [[nodiscard]] std::span<const Symbol> rhs(u32 production) const {
+    const auto &[_, offset, length] = productions_[production];
+    return {rhs_pool_.data() + offset, length};
+  }
+
+  [[nodiscard]] usize terminator_count() const;
+
+  [[nodiscard]] usize nonterminator_count() const;
+
+  [[nodiscard]] usize class_count() const;
+
+  [[nodiscard]] usize slot_count() const;
+
+  // Slots holding a cell of their row.
+  [[nodiscard]] usize used_slot_count() const;
+
+  // Bytes taken by the arrays a lookup reads: classes, bases and slots.
+  [[nodiscard]] usize lookup_bytes() const;
+
+  // The uncompressed table, equal to the one this was built from.
+  [[nodiscard]] PredictionTable prediction_table() const;
+};
+
+} // namespace ep
+
+#endif // EP_PARSER_COMPRESSED_TABLE_H
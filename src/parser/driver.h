@@ -0,0 +1,336 @@
+#pragma once
+
+#ifndef EP_PARSER_DRIVER_H
+#  define EP_PARSER_DRIVER_H
+
+#  include "parser/grammar.h"
+#  include "util/type.h"
+
+#  include <algorithm>
+#  include <span>
+#  include <type_traits>
+#  include <utility>
+#  include <vector>
+
+namespace ep {
+
+// Steps of a recorded parse, in order: the index of every production
+// expanded (a leftmost derivation), with `PredictionTable::no_entry` in
+// place of each input symbol skipped on an error and `resynchronized` in
+// place of each nonterminator popped to recover.
+struct Derivation {
+  static constexpr u32 resynchronized = PredictionTable::no_entry - 1;
+
+  std::vector<u32> steps{};
+  bool accepted{};
+};
+
+// A syntax error: the input position of the offending symbol, and the
+// symbol on top of the stack, which identifies the set of terminators that
+// were expected there. That is the terminator itself, or the terminators
+// of the row of a nonterminator in the prediction table.
+struct ParseError {
+  u32 position{};
+  Symbol expected{};
+};
+
+// The errors of a parse, one per recovery, however many input symbols it
+// skips. Past `limit` errors the parse gives up and rejects at once.
+struct ErrorLog {
+  static constexpr usize default_limit = 16;
+
+  usize limit{default_limit};
+  std::vector<ParseError> errors{};
+};
+
+// Observer that records nothing; parsing stops at the first error.
+struct Recognizer {
+  static constexpr bool stop_on_error = true;
+
+  constexpr void initial(const auto &, auto) {}
+
+  constexpr void popped(const auto &, auto) {}
+
+  constexpr void
+  expanded(const auto &, auto, Symbol, u32, std::span<const Symbol>) {}
+
+  constexpr void mismatched(Symbol, Symbol) {}
+
+  constexpr void skipped(Symbol, Symbol) {}
+
+  constexpr void synchronized(const auto &, auto, Symbol) {}
+
+  constexpr void exhausted(Symbol) {}
+};
+
+// Observer that appends the steps of the parse to a `Derivation`.
+struct DerivationRecorder : Recognizer {
+  static constexpr bool stop_on_error = false;
+
+  std::vector<u32> &steps;
+
+  constexpr explicit DerivationRecorder(std::vector<u32> &steps):
+      steps(steps) {}
+
+  constexpr void expanded(
+      const auto &, auto, Symbol, u32 production, std::span<const Symbol>
+  ) {
+    steps.push_back(production);
+  }
+
+  constexpr void skipped(Symbol, Symbol) {
+    steps.push_back(PredictionTable::no_entry);
+  }
+
+  constexpr void synchronized(const auto &, auto, Symbol) {
+    steps.push_back(Derivation::resynchronized);
+  }
+};
+
+// What a parse did, summed over parses by `+=` (the stack depth is the
+// maximum instead).
+struct ParseCounters {
+  u64 tokens{};
+  u64 expansions{};
+  u64 matches{};    // Input symbols matched, `$` included.
+  u64 recoveries{}; // Errors recovered from, as in `ErrorLog`.
+  u64 max_stack_depth{};
+
+  ParseCounters &operator+=(const ParseCounters &rhs) {
+    tokens += rhs.tokens;
+    expansions += rhs.expansions;
+    matches += rhs.matches;
+    recoveries += rhs.recoveries;
+    max_stack_depth = std::max(max_stack_depth, rhs.max_stack_depth);
+    return *this;
+  }
+};
+
+// Passes every step on to `observer`, counting them in `counters`.
+template<class Observer>
+struct CountingObserver {
+  static constexpr bool stop_on_error = Observer::stop_on_error;
+
+  Observer &observer;
+  ParseCounters &counters;
+  // Whether the next pop is that of an `ε`, which matches nothing.
+  bool popping_empty{};
+
+  void initial(const auto &stack, auto it) {
+    counters.max_stack_depth =
+        std::max<u64>(counters.max_stack_depth, stack.size());
+    observer.initial(stack, it);
+  }
+
+  void popped(const auto &stack, auto it) {
+    counters.matches += !popping_empty;
+    popping_empty = false;
+    observer.popped(stack, it);
+  }
+
+  void expanded(
+      const auto &stack, auto it, Symbol top, u32 production,
+      std::span<const Symbol> prediction
+  ) {
+    ++counters.expansions;
+    counters.max_stack_depth =
+        std::max<u64>(counters.max_stack_depth, stack.size());
+    popping_empty = prediction.size() == 1 &&
+                    prediction.front() == Symbol::empty_symbol();
+    observer.expanded(stack, it, top, production, prediction);
+  }
+
+  void mismatched(Symbol top, Symbol symbol) {
+    observer.mismatched(top, symbol);
+  }
+
+  void skipped(Symbol top, Symbol symbol) {
+    observer.skipped(top, symbol);
+  }
+
+  void synchronized(const auto &stack, auto it, Symbol top) {
+    observer.synchronized(stack, it, top);
+  }
+
+  void exhausted(Symbol top) {
+    observer.exhausted(top);
+  }
+};
+
+// Stands in for a prediction table, answering lookups from a recorded
+// derivation instead, so that replaying it drives the very same steps. A
+// failed lookup leaves the marker of the recovery for `synchronizes`.
+template<class Table>
+class DerivationReplay {
+  const Table &table_;
+  std::span<const u32> steps_;
+  mutable usize pos_{};
+
+public:
+  DerivationReplay(const Table &table, std::span<const u32> steps):
+      table_(table), steps_(steps) {}
+
+  [[nodiscard]] u32 lookup(Symbol, Symbol) const {
+    if (pos_ == steps_.size() || steps_[pos_] >= Derivation::resynchronized)
+      return PredictionTable::no_entry;
+    return steps_[pos_++];
+  }
+
+  [[nodiscard]] bool synchronizes(Symbol, Symbol) const {
+    return pos_ < steps_.size() &&
+           steps_[pos_++] == Derivation::resynchronized;
+  }
+
+  [[nodiscard]] std::span<const Symbol> rhs(u32 production) const {
+    return table_.rhs(production);
+  }
+};
+
+// The LL(1) driver shared by every parse mode. `input` must end with
+// `Symbol::end_symbol()`; `stack` is scratch space. `Table` is anything with
+// `lookup`, `synchronizes` and `rhs` like `PredictionTable`, and `observer`
+// is notified of every step. Returns whether the input was accepted without
+// errors.
+//
+// `Table` may be a `StaticGrammar` itself, whose arrays are then constants
+// the driver reads in place; with such a table the parse also runs in
+// constant evaluation.
+//
+// `input` is a span of symbols, or any range read through its iterator one
+// symbol at a time, such as `LexedInput`, which lexes each symbol as it is
+// first read. It is never read past the symbol the parse stops at.
+//
+// Errors are recovered from in panic mode, unless the observer stops on
+// them: a terminator on top of the stack that does not match is popped, as
+// if it had been there; a nonterminator with no prediction for the input
+// skips it up to a symbol it can start with, or is popped at one in its
+// FOLLOW set or at the end. Each recovery is logged in `errors`, and past
+// its limit the parse is abandoned, so that no input costs more than a
+// bounded number of recoveries.
+template<class Table, class Input, class Observer>
+constexpr bool ll1_parse(
+    const Table &table, Symbol start_symbol, Input &&input,
+    std::vector<Symbol> &stack, Observer &&observer, ErrorLog &errors
+) {
+  errors.errors.clear();
+  const auto first = input.begin();
+  // Logs an error at `it` with `top` on the stack; false if the parse is to
+  // stop there.
+  auto error = [&](Symbol top, auto it) {
+    if (errors.errors.size() == errors.limit)
+      return false;
+    errors.errors.push_back({static_cast<u32>(it - first), top});
+    return !std::decay_t<Observer>::stop_on_error;
+  };
+
+  stack.clear();
+  stack.push_back(Symbol::end_symbol());
+  stack.push_back(start_symbol);
+  observer.initial(stack, first);
+
+  auto it = first;
+  while (!stack.empty()) {
+    const auto top = stack.back();
+    stack.pop_back();
+
+    if (top.type == Symbol::Terminator) {
+      if (top == Symbol::empty_symbol()) {
+        observer.popped(stack, it);
+      } else if (top == *it) {
+        ++it;
+        observer.popped(stack, it);
+      } else {
+        observer.mismatched(top, *it);
+        if (!error(top, it))
+          return false;
+      }
+    } else {
+      u32 production = PredictionTable::no_entry;
+      bool recovering = false, popped = false;
+      for (; it != input.end() && (production = table.lookup(top, *it)) ==
+                                      PredictionTable::no_entry;
+           ++it) {
+        if (!recovering && !error(top, it)) {
+          observer.skipped(top, *it);
+          return false;
+        }
+        recovering = true;
+        if (table.synchronizes(top, *it) || *it == Symbol::end_symbol()) {
+          observer.synchronized(stack, it, top);
+          popped = true;
+          break;
+        }
+        observer.skipped(top, *it);
+      }
+      if (popped)
+        continue;
+      if (it == input.end()) {
+        if (!recovering)
+          error(top, it);
+        observer.exhausted(top);
+        break;
+      }
+      const auto prediction = table.rhs(production);
+      stack.insert(stack.end(), prediction.rbegin(), prediction.rend());
+      observer.expanded(stack, it, top, production, prediction);
+    }
+  }
+
+  return errors.errors.empty();
+}
+
+template<class Table, class Input, class Observer>
+constexpr bool ll1_parse(
+    const Table &table, Symbol start_symbol, Input &&input,
+    std::vector<Symbol> &stack, Observer &&observer
+) {
+  ErrorLog errors;
+  return ll1_parse(
+      table, start_symbol, std::forward<Input>(input), stack,
+      std::forward<Observer>(observer), errors
+  );
+}
+
+enum class StepResult {
+  Shifted,  // The symbol was matched; the parse goes on.
+  Accepted, // The symbol was `Symbol::end_symbol()` and ended the parse.
+  Rejected, // The symbol cannot follow the input so far.
+};
+
+// Resumable form of `ll1_parse` without error recovery: advances the parse
+// held in `stack` by the single input `symbol`. `stack` starts out as
+// `{Symbol::end_symbol(), start_symbol}` and is all the state kept between
+// calls. On rejection it is left as it was at the error. `Stack` is
+// `std::vector<Symbol>` or anything with its `empty`, `back`, `pop_back`
+// and `push_back`.
+template<class Table, class Stack>
+constexpr StepResult
+ll1_step(const Table &table, Symbol symbol, Stack &stack) {
+  while (!stack.empty()) {
+    const auto top = stack.back();
+
+    if (top.type == Symbol::Terminator) {
+      if (top == Symbol::empty_symbol()) {
+        stack.pop_back();
+        continue;
+      }
+      if (top != symbol)
+        return StepResult::Rejected;
+      stack.pop_back();
+      return stack.empty() ? StepResult::Accepted : StepResult::Shifted;
+    }
+
+    const auto production = table.lookup(top, symbol);
+    if (production == PredictionTable::no_entry)
+      return StepResult::Rejected;
+    stack.pop_back();
+    const auto prediction = table.rhs(production);
+    for (auto it = prediction.rbegin(); it != prediction.rend(); ++it)
+      stack.push_back(*it);
+  }
+  return StepResult::Rejected;
+}
+
+} // namespace ep
+
+#endif // EP_PARSER_DRIVER_H
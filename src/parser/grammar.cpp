@@ -4,47 +4,166 @@
 
 #include <algorithm>
 #include <format>
+#include <tuple>
 
 namespace ep {
 
-Symbol::Symbol(std::string v, Type type): v(std::move(v)), type(type) {}
-
-bool Symbol::operator<(const Symbol &rhs) const {
-  return v < rhs.v;
+Symbol SymbolTable::intern(
+    std::string_view name, Symbol::Type type, SymbolOrigin origin
+) {
+  if (auto it = ids_.find(name); it != ids_.end())
+    return it->second;
+
+  if (type == Symbol::NonTerminator)
+    nonterminator_origins_.push_back(origin);
+
+  auto &names =
+      type == Symbol::Terminator ? terminator_names_ : nonterminator_names_;
+  Symbol symbol{static_cast<u32>(names.size()), type};
+  names.emplace_back(name);
+  ids_.emplace(name, symbol);
+  return symbol;
 }
 
-bool Symbol::operator==(const Symbol &rhs) const {
-  return v == rhs.v;
+std::optional<Symbol> SymbolTable::find(std::string_view name) const {
+  if (auto it = ids_.find(name); it != ids_.end())
+    return it->second;
+  return std::nullopt;
 }
 
-Symbol Symbol::empty_symbol() {
-  return {"", Symbol::Terminator};
+const std::string &SymbolTable::name(Symbol symbol) const {
+  if (symbol.type == Symbol::Terminator)
+    return terminator_names_[symbol.id];
+  return nonterminator_names_[symbol.id];
 }
 
-std::string Symbol::to_string() const {
-  if (v.empty())
+std::string SymbolTable::to_string(Symbol symbol) const {
+  if (symbol == Symbol::empty_symbol())
     return "~";
-  return v;
+  return name(symbol);
+}
+
+SymbolOrigin SymbolTable::origin(Symbol symbol) const {
+  if (symbol.type == Symbol::Terminator)
+    return SymbolOrigin::Source;
+  return nonterminator_origins_[symbol.id];
 }
 
-[[nodiscard]] std::string
-to_string(const std::pair<Symbol, std::vector<Symbol>> &production) {
+usize SymbolTable::terminator_count() const {
+  return terminator_names_.size();
+}
+
+usize SymbolTable::nonterminator_count() const {
+  return nonterminator_names_.size();
+}
+
+PredictionTable::PredictionTable(
+    usize terminator_count, usize nonterminator_count
+):
+    terminator_count(terminator_count),
+    nonterminator_count(nonterminator_count),
+    cells(terminator_count * nonterminator_count, no_entry),
+    follow(terminator_count * nonterminator_count, 0) {}
+
+u32 PredictionTable::push_production(Symbol lhs, std::span<const Symbol> rhs) {
+  productions.push_back(
+      {lhs, static_cast<u32>(rhs_pool.size()), static_cast<u32>(rhs.size())}
+  );
+  rhs_pool.insert(rhs_pool.end(), rhs.begin(), rhs.end());
+  return static_cast<u32>(productions.size() - 1);
+}
+
+[[nodiscard]] std::string to_string(
+    const std::pair<Symbol, std::span<const Symbol>> &production,
+    const SymbolTable &symbols
+) {
   const auto &[lhs, rhs] = production;
-  std::string buf = std::format("{} -> ", lhs.to_string());
+  std::string buf = std::format("{} -> ", symbols.to_string(lhs));
   for (const auto &symbol : rhs)
-    buf.append(symbol.to_string()).append(1, ' ');
+    buf.append(symbols.to_string(symbol)).append(1, ' ');
   buf.pop_back();
   return buf;
 }
 
+TerminatorSet::TerminatorSet(usize terminator_count):
+    words_((terminator_count + 63) / 64, 0) {}
+
+bool TerminatorSet::insert(Symbol terminator) {
+  auto word = terminator.id / 64;
+  auto bit = u64{1} << terminator.id % 64;
+  if (word >= words_.size())
+    words_.resize(word + 1, 0);
+  if (words_[word] & bit)
+    return false;
+  words_[word] |= bit;
+  return true;
+}
+
+void TerminatorSet::erase(Symbol terminator) {
+  if (terminator.id / 64 < words_.size())
+    words_[terminator.id / 64] &= ~(u64{1} << terminator.id % 64);
+}
+
+bool TerminatorSet::contains(Symbol terminator) const {
+  return terminator.id / 64 < words_.size() &&
+         words_[terminator.id / 64] >> terminator.id % 64 & 1;
+}
+
+bool TerminatorSet::empty() const {
+  return std::all_of(words_.begin(), words_.end(), [](u64 word) {
+    return word == 0;
+  });
+}
+
+usize TerminatorSet::size() const {
+  usize size = 0;
+  for (auto word : words_)
+    size += static_cast<usize>(__builtin_popcountll(word));
+  return size;
+}
+
+TerminatorSet &TerminatorSet::operator|=(const TerminatorSet &rhs) {
+  if (rhs.words_.size() > words_.size())
+    words_.resize(rhs.words_.size(), 0);
+  for (usize i = 0; i < rhs.words_.size(); ++i)
+    words_[i] |= rhs.words_[i];
+  return *this;
+}
+
+TerminatorSet &TerminatorSet::operator&=(const TerminatorSet &rhs) {
+  if (words_.size() > rhs.words_.size())
+    words_.resize(rhs.words_.size());
+  for (usize i = 0; i < words_.size(); ++i)
+    words_[i] &= rhs.words_[i];
+  return *this;
+}
+
+bool TerminatorSet::operator==(const TerminatorSet &rhs) const {
+  const auto &[shorter, longer] = words_.size() < rhs.words_.size()
+                                      ? std::tie(words_, rhs.words_)
+                                      : std::tie(rhs.words_, words_);
+  return std::equal(shorter.begin(), shorter.end(), longer.begin()) &&
+         std::all_of(
+             longer.begin() + static_cast<isize>(shorter.size()),
+             longer.end(),
+             [](u64 word) {
+               return word == 0;
+             }
+         );
+}
+
 std::string to_string(
-    const std::map<Symbol, std::set<Symbol>> &set, const std::string &name
+    const std::map<Symbol, TerminatorSet> &set, const std::string &name,
+    const SymbolTable &symbols
 ) {
   std::string buf;
   for (const auto &[symbol, symbol_set] : set) {
-    buf.append(name).append("(").append(symbol.to_string()).append(") = {");
+    buf.append(name)
+        .append("(")
+        .append(symbols.to_string(symbol))
+        .append(") = {");
     for (const auto &symbol_ : symbol_set)
-      buf.append(symbol_.to_string()).append(", ");
+      buf.append(symbols.to_string(symbol_)).append(", ");
     if (!symbol_set.empty())
       buf.pop_back(), buf.pop_back();
     buf.append("}\n");
@@ -53,23 +172,51 @@ std::string to_string(
   return buf;
 }
 
-std::string to_string(const PredictionTable &table) {
-  std::set<Symbol> first_dimension{}, second_dimension{};
-  std::map<Symbol, usize> max_column_len{};
+std::string
+to_string(std::span<const LL1Conflict> conflicts, const SymbolTable &symbols) {
+  std::string buf;
+  for (const auto &[nonterminator, terminator, alternatives] : conflicts) {
+    buf.append(std::format(
+        "M[{}, {}] = {{", symbols.to_string(nonterminator),
+        symbols.to_string(terminator)
+    ));
+    for (const auto &rhs : alternatives)
+      buf.append(to_string({nonterminator, rhs}, symbols)).append(", ");
+    buf.pop_back(), buf.pop_back();
+    buf.append("}\n");
+  }
+  return buf;
+}
+
+std::string
+to_string(const PredictionTable &table, const SymbolTable &symbols) {
+  std::vector<Symbol> first_dimension{}, second_dimension{};
+  std::vector<usize> max_column_len(table.terminator_count, 0);
   usize max_first_column_len = 0;
 
-  for (const auto &[lhs, rhs_map] : table) {
-    first_dimension.emplace(lhs);
-    max_first_column_len =
-        std::max(max_first_column_len, lhs.to_string().size());
-    for (const auto &[rhs, production] : rhs_map) {
-      second_dimension.emplace(rhs);
-      max_column_len[rhs] =
-          std::max(max_column_len[rhs], to_string({lhs, production}).size());
+  for (u32 i = 0; i < table.nonterminator_count; ++i) {
+    Symbol lhs{i, Symbol::NonTerminator};
+    for (u32 j = 0; j < table.terminator_count; ++j) {
+      Symbol rhs{j, Symbol::Terminator};
+      if (auto production = table.lookup(lhs, rhs);
+          production != PredictionTable::no_entry) {
+        if (first_dimension.empty() || first_dimension.back() != lhs) {
+          first_dimension.emplace_back(lhs);
+          max_first_column_len =
+              std::max(max_first_column_len, symbols.to_string(lhs).size());
+        }
+        max_column_len[j] = std::max(
+            max_column_len[j],
+            to_string({lhs, table.rhs(production)}, symbols).size()
+        );
+      }
     }
   }
+  for (u32 j = 0; j < table.terminator_count; ++j)
+    if (max_column_len[j] > 0)
+      second_dimension.emplace_back(j, Symbol::Terminator);
 
-  for (auto &[_, len] : max_column_len)
+  for (auto &len : max_column_len)
     len = (len + 3) / 2 * 2;
 
   std::string buf;
@@ -78,22 +225,27 @@ std::string to_string(const PredictionTable &table) {
   // clang-format off
   for (const auto &symbol : second_dimension)
     buf.append(
-        std::format("{:^{}}", symbol.to_string(), max_column_len[symbol])
+        std::format(
+            "{:^{}}", symbols.to_string(symbol), max_column_len[symbol.id]
+        )
     ).append(" | ");
   // clang-format on
   buf.append(1, '\n');
 
   for (const auto &lhs : first_dimension) {
-    buf.append(std::format("{:^{}}", lhs.to_string(), max_first_column_len))
+    buf.append(std::format(
+                   "{:^{}}", symbols.to_string(lhs), max_first_column_len
+               ))
         .append(" | ");
-    auto row = table.find(lhs)->second;
     for (const auto &rhs : second_dimension) {
-      if (auto it = row.find(rhs); it == row.end()) {
-        buf.append(std::format("{:^{}}", "(nul)", max_column_len[rhs]));
+      if (auto production = table.lookup(lhs, rhs);
+          production == PredictionTable::no_entry) {
+        buf.append(std::format("{:^{}}", "(nul)", max_column_len[rhs.id]));
         buf.append(" | ");
       } else {
         buf.append(std::format(
-            "{:^{}}", to_string({lhs, it->second}), max_column_len[rhs]
+            "{:^{}}", to_string({lhs, table.rhs(production)}, symbols),
+            max_column_len[rhs.id]
         ));
         buf.append(" | ");
       }
@@ -114,7 +266,7 @@ Grammar Grammar::from_str(const std::string &str) {
   Grammar grammar{};
   for (auto &&line : split(str, '\n')) {
     auto vec = split(line, " -> ");
-    auto lhs = Symbol(vec[0], Symbol::NonTerminator);
+    auto lhs = grammar.symbols.intern(vec[0], Symbol::NonTerminator);
     auto rhs_vec = std::vector<std::string>(split(vec[1], " | "));
     auto rhs_set = std::set<std::vector<Symbol>>{};
     for (auto &&rhs : rhs_vec) {
@@ -123,9 +275,13 @@ Grammar Grammar::from_str(const std::string &str) {
         if (symbol == "ε")
           rhs_symbol_vec.emplace_back(Symbol::empty_symbol());
         else if (isupper(symbol[0]))
-          rhs_symbol_vec.emplace_back(symbol, Symbol::NonTerminator);
+          rhs_symbol_vec.emplace_back(
+              grammar.symbols.intern(symbol, Symbol::NonTerminator)
+          );
         else
-          rhs_symbol_vec.emplace_back(symbol, Symbol::Terminator);
+          rhs_symbol_vec.emplace_back(
+              grammar.symbols.intern(symbol, Symbol::Terminator)
+          );
       }
       rhs_set.emplace(std::move(rhs_symbol_vec));
     }
@@ -146,14 +302,14 @@ std::string Grammar::to_string() const {
 
   buf.append("Terminators: {");
   for (const auto &terminator : terminators.first)
-    buf.append(terminator.v).append(", ");
+    buf.append(symbols.name(terminator)).append(", ");
   if (!terminators.first.empty())
     buf.pop_back(), buf.pop_back();
   buf.append("}\n");
 
   buf.append("NonTerminators: {");
   for (const auto &nonterminator : nonterminators)
-    buf.append(nonterminator.v).append(", ");
+    buf.append(symbols.name(nonterminator)).append(", ");
   if (!nonterminators.empty())
     buf.pop_back(), buf.pop_back();
   buf.append("}\n");
@@ -161,10 +317,10 @@ std::string Grammar::to_string() const {
   buf.append("Productions: {\n");
 
   for (const auto &[lhs, rhs_set] : productions) {
-    buf.append("  ").append(lhs.v).append(" -> ");
+    buf.append("  ").append(symbols.name(lhs)).append(" -> ");
     for (const auto &rhs : rhs_set) {
       for (const auto &symbol : rhs) {
-        buf.append(symbol.to_string()).append(1, ' ');
+        buf.append(symbols.to_string(symbol)).append(1, ' ');
       }
       buf.append("| ");
     }
@@ -182,7 +338,7 @@ std::pair<std::set<Symbol>, bool> Grammar::get_terminators() const {
   for (const auto &[lhs, rhs_set] : productions)
     for (const auto &rhs : rhs_set)
       for (const auto &symbol : rhs) {
-        if (symbol.v.empty())
+        if (symbol == Symbol::empty_symbol())
           has_empty_symbol = true;
         else if (symbol.type == Symbol::Terminator)
           terminators.emplace(symbol);
@@ -224,117 +380,309 @@ void Grammar::push_production(const Symbol &lhs, std::vector<Symbol> &&rhs) {
   productions[lhs].emplace(std::move(rhs));
 }
 
-inline bool is_left_recursive(const ProductionSet &prod_set) {
-  const auto &[lhs, rhs_set] = prod_set;
-  return std::any_of(rhs_set.begin(), rhs_set.end(), [&](const auto &rhs) {
-    // std::cerr << rhs.front().v << ' ' << lhs.v << '\n';
-    return rhs.front() == lhs;
-  });
+// The strongly connected components of a graph given as the successors of
+// each node, by Tarjan's algorithm. Components are numbered in the order
+// they are finished, which is reverse topological: the successors of a node
+// lie in its own component or in one numbered lower.
+inline std::vector<u32>
+strongly_connected_components(const std::vector<std::vector<u32>> &edges) {
+  constexpr u32 unvisited = ~u32{};
+  const auto node_count = static_cast<u32>(edges.size());
+  std::vector<u32> index(node_count, unvisited), low(node_count);
+  std::vector<u32> component(node_count, unvisited);
+  std::vector<u32> stack{};
+  // The nodes being visited, with the next of their successors to visit.
+  std::vector<std::pair<u32, u32>> visiting{};
+  u32 next_index = 0, next_component = 0;
+
+  auto visit = [&](u32 node) {
+    index[node] = low[node] = next_index++;
+    stack.push_back(node);
+    visiting.emplace_back(node, 0);
+  };
+
+  for (u32 root = 0; root < node_count; ++root) {
+    if (index[root] != unvisited)
+      continue;
+    visit(root);
+
+    while (!visiting.empty()) {
+      auto &[node, next_edge] = visiting.back();
+      if (next_edge < edges[node].size()) {
+        auto successor = edges[node][next_edge++];
+        if (index[successor] == unvisited)
+          visit(successor);
+        else if (component[successor] == unvisited)
+          low[node] = std::min(low[node], index[successor]);
+        continue;
+      }
+
+      auto done = node;
+      visiting.pop_back();
+      if (!visiting.empty()) {
+        auto parent = visiting.back().first;
+        low[parent] = std::min(low[parent], low[done]);
+      }
+      if (low[done] != index[done])
+        continue;
+
+      auto first_member =
+          std::find(stack.rbegin(), stack.rend(), done).base() - 1;
+      for (auto it = first_member; it != stack.end(); ++it)
+        component[*it] = next_component;
+      stack.erase(first_member, stack.end());
+      ++next_component;
+    }
+  }
+  return component;
+}
+
+// The components of the graph leading each nonterminator to those its
+// alternatives start with. An alternative is left recursive, directly or
+// not, iff it starts with a nonterminator of the component of its lhs.
+inline std::vector<u32> left_corner_components(const Grammar &grammar) {
+  std::vector<std::vector<u32>> corners(grammar.symbols.nonterminator_count());
+  for (const auto &[lhs, rhs_set] : grammar.productions)
+    for (const auto &rhs : rhs_set)
+      if (rhs.front().type == Symbol::NonTerminator)
+        corners[lhs.id].push_back(rhs.front().id);
+  return strongly_connected_components(corners);
+}
+
+// `lhs` followed by `rhs`, without the ε either may consist of; ε alone if
+// nothing is left.
+inline std::vector<Symbol>
+concatenate(std::span<const Symbol> lhs, std::span<const Symbol> rhs) {
+  std::vector<Symbol> result{};
+  result.reserve(lhs.size() + rhs.size());
+  for (auto part : {lhs, rhs})
+    for (auto symbol : part)
+      if (symbol != Symbol::empty_symbol())
+        result.push_back(symbol);
+  if (result.empty())
+    result.push_back(Symbol::empty_symbol());
+  return result;
 }
 
 bool Grammar::is_left_recursive() const {
-  return std::any_of(
-      productions.begin(), productions.end(), ep::is_left_recursive
-  );
+  auto component = left_corner_components(*this);
+  for (const auto &[lhs, rhs_set] : productions)
+    for (const auto &rhs : rhs_set)
+      if (rhs.front().type == Symbol::NonTerminator &&
+          component[rhs.front().id] == component[lhs.id])
+        return true;
+  return false;
 }
 
+// The textbook algorithm, confined to the nonterminators on a left
+// recursive cycle; the others are left as they are. In id order, each
+// alternative `A -> B γ` with `B` before `A` on the same cycle is replaced
+// by `A -> δ γ` for every `B -> δ`, which are final by then and start with
+// a nonterminator after `B`, until the recursion left on `A` is direct,
+// and then that is eliminated. Like the textbook algorithm, it assumes that
+// no cycle passes through an alternative deriving ε.
 void Grammar::eliminate_left_recursion() {
-  Grammar new_grammar{};
+  auto component = left_corner_components(*this);
+  auto on_cycle = [&](Symbol lhs, Symbol symbol) {
+    return symbol.type == Symbol::NonTerminator && symbol.id <= lhs.id &&
+           component[symbol.id] == component[lhs.id];
+  };
 
-  for (const auto &[lhs, rhs_set] : productions) {
-    if (!ep::is_left_recursive({lhs, rhs_set})) {
-      new_grammar.push_productions(lhs, rhs_set);
-      continue;
+  std::vector<Symbol> worklist{};
+  for (const auto &[lhs, rhs_set] : productions)
+    if (std::any_of(rhs_set.begin(), rhs_set.end(), [&](const auto &rhs) {
+          return on_cycle(lhs, rhs.front());
+        }))
+      worklist.push_back(lhs);
+
+  for (auto lhs : worklist) {
+    auto &rhs_set = productions[lhs];
+    std::vector<std::vector<Symbol>> pending{};
+    while (!rhs_set.empty())
+      pending.push_back(std::move(rhs_set.extract(rhs_set.begin()).value()));
+
+    // The tails `α` of the alternatives `A -> A α`; `A -> A` is dropped.
+    std::set<std::vector<Symbol>> tails{};
+    while (!pending.empty()) {
+      auto rhs = std::move(pending.back());
+      pending.pop_back();
+      auto front = rhs.front();
+      if (front == lhs) {
+        if (rhs.size() > 1)
+          tails.emplace(rhs.begin() + 1, rhs.end());
+      } else if (on_cycle(lhs, front)) {
+        for (const auto &alternative : productions.at(front))
+          pending.push_back(
+              concatenate(alternative, std::span(rhs).subspan(1))
+          );
+      } else {
+        rhs_set.emplace(std::move(rhs));
+      }
     }
+    if (tails.empty())
+      continue;
+
+    auto new_name = symbols.name(lhs) + "'";
+    while (symbols.find(new_name))
+      new_name += '\'';
+    Symbol new_lhs = symbols.intern(
+        new_name, Symbol::NonTerminator, SymbolOrigin::LeftRecursion
+    );
 
-    Symbol new_lhs{lhs.v + "'", Symbol::NonTerminator};
     std::set<std::vector<Symbol>> new_rhs_set{};
-    std::set<std::vector<Symbol>> old_rhs_set{};
-
-    for (auto &&rhs : rhs_set) {
-      if (rhs.front() == lhs) {
-        auto new_rhs = rhs;
-        new_rhs.erase(new_rhs.begin());
-        new_rhs.emplace_back(new_lhs);
-        new_rhs_set.emplace(std::move(new_rhs));
-      } else {
-        auto old_rhs = rhs;
-        old_rhs.emplace_back(new_lhs);
-        old_rhs_set.emplace(std::move(old_rhs));
-      }
+    while (!rhs_set.empty()) {
+      auto node = rhs_set.extract(rhs_set.begin());
+      if (node.value().front() == Symbol::empty_symbol())
+        node.value().clear();
+      node.value().push_back(new_lhs);
+      new_rhs_set.insert(std::move(node));
     }
+    rhs_set = std::move(new_rhs_set);
 
-    new_grammar.push_productions(lhs, std::move(old_rhs_set));
-    new_grammar.push_productions(new_lhs, std::move(new_rhs_set));
-    new_grammar.push_production(new_lhs, {Symbol::empty_symbol()});
+    auto &new_lhs_rhs_set = productions[new_lhs];
+    while (!tails.empty()) {
+      auto node = tails.extract(tails.begin());
+      node.value().push_back(new_lhs);
+      new_lhs_rhs_set.insert(std::move(node));
+    }
+    new_lhs_rhs_set.insert({Symbol::empty_symbol()});
   }
-
-  *this = std::move(new_grammar);
 }
 
-inline bool is_left_factorable(const ProductionSet &prod_set) {
-  const auto &[_, rhs_set] = prod_set;
-  for (const auto &rhs1 : rhs_set) {
-    if (!rhs1.empty())
-      for (const auto &rhs2 : rhs_set) {
-        if (!rhs2.empty())
-          if (&rhs1 != &rhs2 && rhs1.front() == rhs2.front())
-            return true;
-      }
-  }
-  return false;
+// The alternatives are sorted, so those sharing their first symbol are
+// adjacent.
+inline bool is_left_factorable(const std::set<std::vector<Symbol>> &rhs_set) {
+  return std::adjacent_find(
+             rhs_set.begin(), rhs_set.end(),
+             [](const auto &lhs, const auto &rhs) {
+               return lhs.front() == rhs.front();
+             }
+         ) != rhs_set.end();
 }
 
 bool Grammar::is_left_factored() const {
   return std::any_of(
-      productions.begin(), productions.end(), ep::is_left_factorable
+      productions.begin(), productions.end(),
+      [](const auto &production) {
+        return is_left_factorable(production.second);
+      }
   );
 }
 
+// A worklist of the nonterminators that may have alternatives sharing a
+// prefix: all of them at first, then each one introduced here. The longest
+// prefix shared by a run of alternatives is that of the first and the last
+// of them, as they are sorted, so it is factored out at once into
+// `A -> prefix A1`, with `A1` deriving what is left of each, or ε. Only
+// `A1` may need factoring again.
 void Grammar::extract_left_factoring() {
-  for (bool changed;;) {
-    changed = false;
+  std::vector<Symbol> worklist{};
+  worklist.reserve(productions.size());
+  for (const auto &[lhs, _] : productions)
+    worklist.push_back(lhs);
+
+  for (usize next = 0; next < worklist.size(); ++next) {
+    auto lhs = worklist[next];
+    auto &rhs_set = productions[lhs];
+    if (!is_left_factorable(rhs_set))
+      continue;
 
-    Grammar new_grammar{};
-    for (const auto &[lhs, rhs_set] : productions) {
-      std::map<Symbol, std::set<std::vector<Symbol>>> new_rhs_set_map{};
+    std::set<std::vector<Symbol>> new_rhs_set{};
+    u32 counter = 0;
+    for (auto first = rhs_set.begin(); first != rhs_set.end();) {
+      auto last = first, end = std::next(first);
+      for (; end != rhs_set.end() && end->front() == first->front(); ++end)
+        last = end;
+      if (first == last) {
+        new_rhs_set.insert(rhs_set.extract(first));
+        first = end;
+        continue;
+      }
 
-      for (const auto &rhs : rhs_set) {
+      auto shared = std::mismatch(
+          first->begin(), first->end(), last->begin(), last->end()
+      );
+      auto prefix = shared.first - first->begin();
+      std::string new_name{};
+      do
+        new_name = symbols.name(lhs) + std::to_string(++counter);
+      while (symbols.find(new_name));
+      Symbol new_lhs = symbols.intern(
+          new_name, Symbol::NonTerminator, SymbolOrigin::LeftFactoring
+      );
+
+      std::vector<Symbol> head(first->begin(), first->begin() + prefix);
+      head.push_back(new_lhs);
+      new_rhs_set.emplace(std::move(head));
+
+      auto &new_lhs_rhs_set = productions[new_lhs];
+      while (first != end) {
+        auto node = rhs_set.extract(first++);
+        auto &rhs = node.value();
+        rhs.erase(rhs.begin(), rhs.begin() + prefix);
         if (rhs.empty())
-          continue;
-
-        auto new_rhs = rhs;
-        new_rhs.erase(new_rhs.begin());
-        new_rhs_set_map[rhs.front()].emplace(std::move(new_rhs));
+          rhs.push_back(Symbol::empty_symbol());
+        new_lhs_rhs_set.insert(std::move(node));
       }
+      worklist.push_back(new_lhs);
+    }
+    rhs_set = std::move(new_rhs_set);
+  }
+}
 
-      int counter = 0;
-      for (const auto &[symbol, new_rhs_set] : new_rhs_set_map) {
-        if (new_rhs_set.size() > 1) {
-          ++counter;
-          // clang-format off
-          Symbol new_lhs{
-            lhs.v + std::to_string(counter), Symbol::NonTerminator
-          };
-          new_grammar.push_productions(lhs, {{symbol, new_lhs}});
-          new_grammar.push_productions(new_lhs, new_rhs_set);
-          // clang-format on
-        } else {
-          std::vector<Symbol> new_rhs{symbol};
-          new_rhs.insert(
-              new_rhs.end(), new_rhs_set.begin()->begin(),
-              new_rhs_set.begin()->end()
-          );
-          new_grammar.push_production(lhs, std::move(new_rhs));
-        }
-      }
-      changed |= counter > 0;
+// Each set in `sets` grows into the union of the sets of every node it
+// reaches through `sources`, where `sources[v]` lists the nodes whose sets
+// flow into that of `v`. The strongly connected components come in reverse
+// topological order, so each is merged once, from its own nodes and the
+// components it reaches, which are all final by then; no set is ever
+// revisited.
+inline void propagate(
+    const std::vector<std::vector<u32>> &sources,
+    std::vector<TerminatorSet> &sets
+) {
+  const auto node_count = static_cast<u32>(sources.size());
+  auto component = strongly_connected_components(sources);
+
+  // The nodes grouped by component, by counting sort.
+  std::vector<u32> start(node_count + 1, 0), members(node_count);
+  for (auto c : component)
+    ++start[c + 1];
+  for (u32 c = 0; c < node_count; ++c)
+    start[c + 1] += start[c];
+  auto next = start;
+  for (u32 node = 0; node < node_count; ++node)
+    members[next[component[node]]++] = node;
+
+  for (u32 c = 0; c < node_count && start[c] < node_count; ++c) {
+    TerminatorSet merged{};
+    for (auto i = start[c]; i < start[c + 1]; ++i) {
+      merged |= sets[members[i]];
+      for (auto source : sources[members[i]])
+        if (component[source] != c)
+          merged |= sets[source];
     }
-    *this = std::move(new_grammar);
+    for (auto i = start[c]; i < start[c + 1]; ++i)
+      sets[members[i]] = merged;
+  }
+}
 
-    if (!changed)
-      break;
+TerminatorSet
+first_of(const FirstSet &first_set, std::span<const Symbol> sequence) {
+  TerminatorSet result{};
+  for (const auto &symbol : sequence) {
+    if (symbol == Symbol::empty_symbol())
+      continue;
+    auto it = first_set.find(symbol);
+    if (it == first_set.end())
+      return result;
+    result |= it->second;
+    if (!it->second.contains(Symbol::empty_symbol())) {
+      result.erase(Symbol::empty_symbol());
+      return result;
+    }
   }
+  result.insert(Symbol::empty_symbol());
+  return result;
 }
 
 FirstSet Grammar::build_first_set() const {
@@ -343,33 +691,80 @@ FirstSet Grammar::build_first_set() const {
   auto terminators = get_terminators();
 
   for (const auto &terminator : terminators.first)
-    first_set[terminator].emplace(terminator);
+    first_set[terminator].insert(terminator);
   if (terminators.second)
-    first_set[Symbol::empty_symbol()].emplace(Symbol::empty_symbol());
-
-  for (bool changed;;) {
-    changed = false;
-
-    for (const auto &[lhs, rhs_set] : productions) {
-      for (const auto &rhs : rhs_set) {
-        if (rhs.empty()) {
-          changed |= first_set[lhs].emplace(Symbol::empty_symbol()).second;
-          continue;
+    first_set[Symbol::empty_symbol()].insert(Symbol::empty_symbol());
+
+  const auto nonterminator_count = symbols.nonterminator_count();
+
+  // Which nonterminators derive ε, by a worklist over the productions made
+  // of nonterminators and ε only: each counts its nonterminators not yet
+  // known to be nullable, and is nullable once that count drops to zero.
+  std::vector<bool> nullable(nonterminator_count, false);
+  std::vector<std::pair<Symbol, usize>> candidates{};
+  std::vector<std::vector<u32>> occurrences(nonterminator_count);
+  std::vector<Symbol> worklist{};
+  auto mark_nullable = [&](Symbol nonterminator) {
+    if (!nullable[nonterminator.id]) {
+      nullable[nonterminator.id] = true;
+      worklist.push_back(nonterminator);
+    }
+  };
+  for (const auto &[lhs, rhs_set] : productions) {
+    for (const auto &rhs : rhs_set) {
+      if (std::any_of(rhs.begin(), rhs.end(), [](Symbol symbol) {
+            return symbol.type == Symbol::Terminator &&
+                   symbol != Symbol::empty_symbol();
+          }))
+        continue;
+      auto candidate = static_cast<u32>(candidates.size());
+      usize pending = 0;
+      for (const auto &symbol : rhs)
+        if (symbol.type == Symbol::NonTerminator) {
+          occurrences[symbol.id].push_back(candidate);
+          ++pending;
         }
+      candidates.emplace_back(lhs, pending);
+      if (pending == 0)
+        mark_nullable(lhs);
+    }
+  }
+  while (!worklist.empty()) {
+    auto nonterminator = worklist.back();
+    worklist.pop_back();
+    for (auto candidate : occurrences[nonterminator.id])
+      if (auto &[lhs, pending] = candidates[candidate]; --pending == 0)
+        mark_nullable(lhs);
+  }
 
-        auto old_size = first_set[lhs].size();
-        for (const auto &symbol : rhs) {
-          auto &first_set_rhs = first_set[symbol];
-          first_set[lhs].insert(first_set_rhs.begin(), first_set_rhs.end());
-          if (!first_set_rhs.contains(Symbol::empty_symbol()))
-            break;
+  // FIRST(A) takes the terminators that can start a right hand side of A
+  // directly, and all of FIRST(B) for each B that can, ε aside.
+  std::vector<TerminatorSet> sets(
+      nonterminator_count, TerminatorSet(symbols.terminator_count())
+  );
+  std::vector<std::vector<u32>> sources(nonterminator_count);
+  for (const auto &[lhs, rhs_set] : productions) {
+    for (const auto &rhs : rhs_set) {
+      for (const auto &symbol : rhs) {
+        if (symbol == Symbol::empty_symbol())
+          continue;
+        if (symbol.type == Symbol::Terminator) {
+          sets[lhs.id].insert(symbol);
+          break;
         }
-        changed |= first_set[lhs].size() != old_size;
+        sources[lhs.id].push_back(symbol.id);
+        if (!nullable[symbol.id])
+          break;
       }
     }
+  }
+  propagate(sources, sets);
 
-    if (!changed)
-      break;
+  for (const auto &nonterminator : get_nonterminators()) {
+    auto &first_set_nonterminator = first_set[nonterminator];
+    first_set_nonterminator = std::move(sets[nonterminator.id]);
+    if (nullable[nonterminator.id])
+      first_set_nonterminator.insert(Symbol::empty_symbol());
   }
 
   return first_set;
@@ -378,45 +773,48 @@ FirstSet Grammar::build_first_set() const {
 FollowSet Grammar::build_follow_set(
     FirstSet &first_set, const Symbol &start_symbol
 ) const {
-  FollowSet follow_set{};
+  // FOLLOW(B) takes FIRST of what follows B in a right hand side of A, ε
+  // aside, and all of FOLLOW(A) if that can derive ε.
+  const auto nonterminator_count = symbols.nonterminator_count();
+  std::vector<TerminatorSet> sets(
+      nonterminator_count, TerminatorSet(symbols.terminator_count())
+  );
+  std::vector<std::vector<u32>> sources(nonterminator_count);
 
-  auto terminators = get_terminators();
+  sets[start_symbol.id].insert(Symbol::end_symbol());
+
+  for (const auto &[lhs, rhs_set] : productions) {
+    for (const auto &rhs : rhs_set) {
+      // FIRST of the suffix after the current symbol, ε aside.
+      TerminatorSet suffix_first(symbols.terminator_count());
+      bool suffix_nullable = true;
+      for (auto it = rhs.rbegin(); it != rhs.rend(); ++it) {
+        if (*it == Symbol::empty_symbol())
+          continue;
+        if (it->type == Symbol::NonTerminator) {
+          sets[it->id] |= suffix_first;
+          if (suffix_nullable)
+            sources[it->id].push_back(lhs.id);
+        }
 
-  follow_set[start_symbol].emplace("$", Symbol::Terminator);
-
-  for (bool changed;;) {
-    changed = false;
-
-    for (const auto &[lhs, rhs_set] : productions) {
-      for (const auto &rhs : rhs_set) {
-        for (auto it = rhs.begin(); it != rhs.end(); ++it) {
-          if (it->type == Symbol::Terminator)
-            continue;
-
-          auto &follow_set_lhs = follow_set[*it];
-          auto old_size = follow_set_lhs.size();
-
-          auto it2 = std::next(it);
-          if (it2 != rhs.end()) {
-            auto &first_set_rhs = first_set[*it2];
-            for (const auto &symbol : first_set_rhs)
-              if (symbol != Symbol::empty_symbol())
-                follow_set_lhs.emplace(symbol);
-          }
-          if (it2 == rhs.end() ||
-              first_set[*it2].contains(Symbol::empty_symbol()))
-            follow_set_lhs.insert(
-                follow_set[lhs].begin(), follow_set[lhs].end()
-            );
-
-          changed |= follow_set_lhs.size() != old_size;
+        const auto &first_set_symbol = first_set[*it];
+        if (!first_set_symbol.contains(Symbol::empty_symbol())) {
+          suffix_first = first_set_symbol;
+          suffix_nullable = false;
+        } else {
+          suffix_first |= first_set_symbol;
+          suffix_first.erase(Symbol::empty_symbol());
         }
       }
     }
-
-    if (!changed)
-      break;
   }
+  propagate(sources, sets);
+
+  FollowSet follow_set{};
+  follow_set[start_symbol] = std::move(sets[start_symbol.id]);
+  for (const auto &nonterminator : get_nonterminators())
+    if (nonterminator != start_symbol)
+      follow_set[nonterminator] = std::move(sets[nonterminator.id]);
 
   return follow_set;
 }
@@ -427,55 +825,46 @@ std::optional<std::string> Grammar::is_ll1(const Symbol &start_symbol) const {
   return is_ll1(first_set, follow_set);
 }
 
-std::optional<std::string>
-Grammar::is_ll1(FirstSet &first_set, FollowSet &follow_set) const {
+std::vector<LL1Conflict> Grammar::find_conflicts(
+    const FirstSet &first_set, const FollowSet &follow_set
+) const {
+  std::vector<LL1Conflict> conflicts{};
+  std::vector<TerminatorSet> predicted{};
+
   for (const auto &[lhs, rhs_set] : productions) {
+    // The cells each alternative claims, ε included for a nullable one so
+    // that two of them conflict even where FOLLOW is empty.
+    const auto follow_set_lhs = follow_set.find(lhs);
+    predicted.clear();
+    TerminatorSet claimed{}, conflicting{};
     for (const auto &rhs : rhs_set) {
-      if (rhs.empty())
-        continue;
-
-      auto &first_set_rhs = first_set[rhs.front()];
-      if (first_set_rhs.contains(Symbol::empty_symbol())) {
-        auto &follow_set_lhs = follow_set[lhs];
-        for (const auto &symbol : follow_set_lhs)
-          if (first_set_rhs.contains(symbol)) {
-            std::string buf = std::format(
-                "FIRST({}) ∩ FOLLOW({}) = {{", rhs.front().v, lhs.v
-            );
-            for (const auto &symbol_ : first_set_rhs)
-              buf.append(symbol_.to_string()).append(", ");
-            buf.pop_back(), buf.pop_back();
-            buf.append("}\n");
-            return buf;
-          }
-      }
+      auto cells = first_of(first_set, rhs);
+      if (cells.contains(Symbol::empty_symbol()) &&
+          follow_set_lhs != follow_set.end())
+        cells |= follow_set_lhs->second;
+      conflicting |= claimed & cells;
+      claimed |= cells;
+      predicted.push_back(std::move(cells));
     }
 
-    for (auto it1 = rhs_set.begin(); it1 != rhs_set.end(); ++it1) {
-      for (auto it2 = std::next(it1); it2 != rhs_set.end(); ++it2) {
-        auto &first_set_rhs1 = first_set[*it1->begin()];
-        auto &first_set_rhs2 = first_set[*it2->begin()];
-
-        std::set<Symbol> intersection{};
-        std::set_intersection(
-            first_set_rhs1.begin(), first_set_rhs1.end(),
-            first_set_rhs2.begin(), first_set_rhs2.end(),
-            std::inserter(intersection, intersection.begin())
-        );
-        if (!intersection.empty()) {
-          std::string buf = std::format(
-              "FIRST({}) ∩ FIRST({}) = {{", it1->begin()->v, it2->begin()->v
-          );
-          for (const auto &symbol : intersection)
-            buf.append(symbol.to_string()).append(", ");
-          buf.pop_back(), buf.pop_back();
-          buf.append("}\n");
-          return buf;
-        }
-      }
+    for (const auto &terminator : conflicting) {
+      auto &conflict = conflicts.emplace_back(LL1Conflict{lhs, terminator});
+      auto cells = predicted.begin();
+      for (const auto &rhs : rhs_set)
+        if ((cells++)->contains(terminator))
+          conflict.alternatives.push_back(rhs);
     }
   }
-  return std::nullopt;
+
+  return conflicts;
+}
+
+std::optional<std::string>
+Grammar::is_ll1(FirstSet &first_set, FollowSet &follow_set) const {
+  auto conflicts = find_conflicts(first_set, follow_set);
+  if (conflicts.empty())
+    return std::nullopt;
+  return ep::to_string(conflicts, symbols);
 }
 
 PredictionTable Grammar::build_prediction_table(const Symbol &start_symbol
@@ -488,32 +877,31 @@ PredictionTable Grammar::build_prediction_table(const Symbol &start_symbol
 PredictionTable Grammar::build_prediction_table(
     FirstSet &first_set, FollowSet &follow_set
 ) const {
-  PredictionTable prediction_table{};
+  PredictionTable prediction_table{
+      symbols.terminator_count(), symbols.nonterminator_count()
+  };
+
+  auto predict = [&](Symbol lhs, Symbol symbol, u32 production) {
+    if (symbol != Symbol::empty_symbol())
+      prediction_table.at(lhs, symbol) = production;
+  };
 
   for (const auto &[lhs, rhs_set] : productions) {
     for (const auto &rhs : rhs_set) {
-      auto &first_set_rhs = first_set[rhs.front()];
-      for (const auto &symbol : first_set_rhs)
-        prediction_table[lhs][symbol] = rhs;
-
-      if (first_set_rhs.contains(Symbol::empty_symbol()))
-        for (const auto &symbol : follow_set[lhs])
-          prediction_table[lhs][symbol] = rhs;
+      auto production = prediction_table.push_production(lhs, rhs);
 
-      if (rhs.empty()) {
-        for (const auto &symbol : follow_set[lhs])
-          prediction_table[lhs][symbol] = rhs;
-        continue;
-      }
+      auto cells = first_of(first_set, rhs);
+      if (cells.contains(Symbol::empty_symbol()))
+        cells |= follow_set[lhs];
+      for (const auto &symbol : cells)
+        predict(lhs, symbol, production);
     }
   }
 
-  for (auto &[lhs, rhs_map] : prediction_table)
-    for (auto it = rhs_map.begin(); it != rhs_map.end();)
-      if (it->first == Symbol::empty_symbol())
-        it = rhs_map.erase(it);
-      else
-        ++it;
+  for (const auto &[lhs, terminators] : follow_set)
+    for (const auto &symbol : terminators)
+      prediction_table.follow
+          [lhs.id * prediction_table.terminator_count + symbol.id] = 1;
 
   return prediction_table;
 }
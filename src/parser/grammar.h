@@ -5,54 +5,253 @@
 
 #endif // EP_PARSER_GRAMMAR_H
 
+#include "util/type.h"
+
+#include <iterator>
 #include <map>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 namespace ep {
 
+// A grammar symbol is a dense index into the `SymbolTable` of the grammar
+// it belongs to. Terminators and nonterminators are numbered separately, so
+// the id can be used directly as a row / column index.
 struct Symbol {
-  std::string v{};
+  u32 id{};
 
-  enum Type { Terminator, NonTerminator } type;
+  enum Type : u32 { Terminator, NonTerminator } type{Terminator};
 
-  Symbol(const Symbol &rhs) = default;
+  constexpr Symbol() = default;
 
-  Symbol(Symbol &&rhs) noexcept = default;
+  constexpr Symbol(u32 id, Type type): id(id), type(type) {}
 
-  Symbol &operator=(const Symbol &rhs) = default;
+  constexpr bool operator<(const Symbol &rhs) const {
+    return type != rhs.type ? type < rhs.type : id < rhs.id;
+  }
 
-  Symbol &operator=(Symbol &&rhs) noexcept = default;
+  constexpr bool operator==(const Symbol &rhs) const = default;
 
-  Symbol(std::string v, Type type);
+  // Terminator #0 and #1 are reserved in every symbol table.
+  static constexpr Symbol empty_symbol() {
+    return {0, Terminator};
+  }
 
-  bool operator<(const Symbol &rhs) const;
+  static constexpr Symbol end_symbol() {
+    return {1, Terminator};
+  }
+};
 
-  bool operator==(const Symbol &rhs) const;
+// Where a nonterminator comes from: written in the grammar, or introduced by
+// one of the transformations (e.g. `E'` and `E1` for `E`).
+enum class SymbolOrigin : u8 { Source, LeftRecursion, LeftFactoring };
+
+class SymbolTable {
+  std::vector<std::string> terminator_names_{"", "$"};
+  std::vector<std::string> nonterminator_names_{};
+  std::vector<SymbolOrigin> nonterminator_origins_{};
+  std::map<std::string, Symbol, std::less<>> ids_{
+      {"",  Symbol::empty_symbol()},
+      {"$", Symbol::end_symbol()  }
+  };
+
+public:
+  Symbol intern(
+      std::string_view name, Symbol::Type type,
+      SymbolOrigin origin = SymbolOrigin::Source
+  );
 
-  static Symbol empty_symbol();
+  [[nodiscard]] std::optional<Symbol> find(std::string_view name) const;
 
-  [[nodiscard]] std::string to_string() const;
+  [[nodiscard]] const std::string &name(Symbol symbol) const;
+
+  [[nodiscard]] std::string to_string(Symbol symbol) const;
+
+  [[nodiscard]] SymbolOrigin origin(Symbol symbol) const;
+
+  [[nodiscard]] usize terminator_count() const;
+
+  [[nodiscard]] usize nonterminator_count() const;
+};
+
+// Set of terminators as a bitset over their ids, so that unions and
+// intersections run a word at a time. It grows as needed; iterating it
+// yields the terminators in id order.
+class TerminatorSet {
+  std::vector<u64> words_{};
+
+public:
+  class iterator {
+    const u64 *words_{};
+    usize word_count_{};
+    usize word_{};
+    u64 bits_{};
+
+    void skip_empty_words() {
+      while (bits_ == 0 && ++word_ < word_count_)
+        bits_ = words_[word_];
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Symbol;
+    using difference_type = isize;
+    using pointer = void;
+    using reference = Symbol;
+
+    iterator() = default;
+
+    iterator(const u64 *words, usize word_count, usize word):
+        words_(words), word_count_(word_count), word_(word),
+        bits_(word < word_count ? words[word] : 0) {
+      if (word_ < word_count_)
+        skip_empty_words();
+    }
+
+    Symbol operator*() const {
+      return {
+          static_cast<u32>(word_ * 64 + __builtin_ctzll(bits_)),
+          Symbol::Terminator
+      };
+    }
+
+    iterator &operator++() {
+      bits_ &= bits_ - 1;
+      skip_empty_words();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    bool operator==(const iterator &rhs) const {
+      return word_ == rhs.word_ && bits_ == rhs.bits_;
+    }
+  };
+
+  TerminatorSet() = default;
+
+  explicit TerminatorSet(usize terminator_count);
+
+  [[nodiscard]] iterator begin() const {
+    return {words_.data(), words_.size(), 0};
+  }
+
+  [[nodiscard]] iterator end() const {
+    return {words_.data(), words_.size(), words_.size()};
+  }
+
+  // Returns whether `terminator` was not in the set yet.
+  bool insert(Symbol terminator);
+
+  void erase(Symbol terminator);
+
+  [[nodiscard]] bool contains(Symbol terminator) const;
+
+  [[nodiscard]] bool empty() const;
+
+  [[nodiscard]] usize size() const;
+
+  TerminatorSet &operator|=(const TerminatorSet &rhs);
+
+  TerminatorSet &operator&=(const TerminatorSet &rhs);
+
+  [[nodiscard]] friend TerminatorSet
+  operator&(TerminatorSet lhs, const TerminatorSet &rhs) {
+    return lhs &= rhs;
+  }
+
+  [[nodiscard]] bool operator==(const TerminatorSet &rhs) const;
 };
 
 using ProductionSet = std::pair<Symbol, std::set<std::vector<Symbol>>>;
-using FirstSet = std::map<Symbol, std::set<Symbol>>;
-using FollowSet = std::map<Symbol, std::set<Symbol>>;
-using PredictionTable = std::map<Symbol, std::map<Symbol, std::vector<Symbol>>>;
+using FirstSet = std::map<Symbol, TerminatorSet>;
+using FollowSet = std::map<Symbol, TerminatorSet>;
+
+// FIRST of a sequence of symbols, with ε if the whole sequence can derive it.
+[[nodiscard]] TerminatorSet
+first_of(const FirstSet &first_set, std::span<const Symbol> sequence);
+
+// A cell of the prediction table claimed by more than one alternative. A
+// terminator of ε stands for more than one alternative deriving ε.
+struct LL1Conflict {
+  Symbol nonterminator{};
+  Symbol terminator{};
+  std::vector<std::vector<Symbol>> alternatives{};
+};
 
-[[nodiscard]] std::string
-to_string(const std::pair<Symbol, std::vector<Symbol>> &production);
+struct Production {
+  Symbol lhs{};
+  u32 rhs_offset{};
+  u32 rhs_length{};
+};
+
+// Compiled LL(1) table: `cells` is a nonterminator-major
+// [nonterminator][terminator] array of production indices, and the right hand
+// sides of all productions are stored back to back in `rhs_pool`.
+struct PredictionTable {
+  static constexpr u32 no_entry = ~u32{};
+
+  usize terminator_count{};
+  usize nonterminator_count{};
+  std::vector<u32> cells{};
+  // The FOLLOW set of every nonterminator, as flags laid out like `cells`.
+  std::vector<u8> follow{};
+  std::vector<Production> productions{};
+  std::vector<Symbol> rhs_pool{};
+
+  PredictionTable() = default;
+
+  PredictionTable(usize terminator_count, usize nonterminator_count);
+
+  u32 push_production(Symbol lhs, std::span<const Symbol> rhs);
+
+  [[nodiscard]] u32 lookup(Symbol nonterminator, Symbol terminator) const {
+    return cells[nonterminator.id * terminator_count + terminator.id];
+  }
+
+  [[nodiscard]] u32 &at(Symbol nonterminator, Symbol terminator) {
+    return cells[nonterminator.id * terminator_count + terminator.id];
+  }
+
+  // Whether error recovery may pop `nonterminator` at `terminator`.
+  [[nodiscard]] bool
+  synchronizes(Symbol nonterminator, Symbol terminator) const {
+    return follow[nonterminator.id * terminator_count + terminator.id] != 0;
+  }
+
+  [[nodiscard]] std::span<const Symbol> rhs(u32 production) const {
+    const auto &[_, offset, length] = productions[production];
+    return {rhs_pool.data() + offset, length};
+  }
+};
 
 [[nodiscard]] std::string to_string(
-    const std::map<Symbol, std::set<Symbol>> &set, const std::string &name
+    const std::pair<Symbol, std::span<const Symbol>> &production,
+    const SymbolTable &symbols
 );
 
-[[nodiscard]] std::string to_string(const PredictionTable &table);
+[[nodiscard]] std::string to_string(
+    const std::map<Symbol, TerminatorSet> &set, const std::string &name,
+    const SymbolTable &symbols
+);
+
+[[nodiscard]] std::string
+to_string(std::span<const LL1Conflict> conflicts, const SymbolTable &symbols);
+
+[[nodiscard]] std::string
+to_string(const PredictionTable &table, const SymbolTable &symbols);
 
 struct Grammar {
+  SymbolTable symbols{};
   std::map<Symbol, std::set<std::vector<Symbol>>> productions{};
 
   Grammar() = default;
@@ -100,6 +299,11 @@ struct Grammar {
   [[nodiscard]] std::optional<std::string> is_ll1(const Symbol &start_symbol
   ) const;
 
+  // Every conflict, not just the first; none if the grammar is LL(1).
+  [[nodiscard]] std::vector<LL1Conflict>
+  find_conflicts(const FirstSet &first_set, const FollowSet &follow_set) const;
+
+  // A report of all conflicts, if any.
   [[nodiscard]] std::optional<std::string>
   is_ll1(FirstSet &first_set, FollowSet &follow_set) const;
 
@@ -0,0 +1,427 @@
+#include "parser/incremental_parser.h"
+
+#include "parser/driver.h"
+#include "simple_lexer/lexer.h"
+
+#include <algorithm>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+namespace ep {
+
+namespace {
+
+inline Span span_of(const Token &token) {
+  return std::visit(
+      [](const auto &token) {
+        return token.span;
+      },
+      token
+  );
+}
+
+inline void set_offset(Token &token, usize offset) {
+  std::visit(
+      [&](auto &token) {
+        token.span.offset = static_cast<u32>(offset);
+      },
+      token
+  );
+}
+
+} // namespace
+
+usize TokenBlocks::block_of(usize index) const {
+  // Tokens are mostly read in order, so the block of the last call and the
+  // one after it are tried first.
+  for (auto i = hint_; i < blocks_.size() && i <= hint_ + 1; ++i)
+    if (blocks_[i].first <= index &&
+        (i + 1 == blocks_.size() || index < blocks_[i + 1].first))
+      return hint_ = i;
+  auto it = std::upper_bound(
+      blocks_.begin(), blocks_.end(), index,
+      [](usize index, const Block &block) {
+        return index < block.first;
+      }
+  );
+  return hint_ = static_cast<usize>(it - blocks_.begin()) - 1;
+}
+
+void TokenBlocks::rebuild(usize from, usize to, usize first) {
+  // Equal blocks of at most `block_size` entries.
+  auto count = (spliced_.size() + block_size - 1) / block_size;
+  std::vector<Block> blocks(count);
+  for (usize i = 0, begin = 0; i < count; ++i) {
+    auto end = spliced_.size() * (i + 1) / count;
+    auto &block = blocks[i];
+    block.offset = span_of(spliced_[begin].token).offset;
+    block.first = first + begin;
+    block.entries.assign(
+        spliced_.begin() + static_cast<isize>(begin),
+        spliced_.begin() + static_cast<isize>(end)
+    );
+    for (auto &entry : block.entries)
+      set_offset(entry.token, span_of(entry.token).offset - block.offset);
+    begin = end;
+  }
+  blocks_.erase(
+      blocks_.begin() + static_cast<isize>(from),
+      blocks_.begin() + static_cast<isize>(to)
+  );
+  blocks_.insert(
+      blocks_.begin() + static_cast<isize>(from),
+      std::make_move_iterator(blocks.begin()),
+      std::make_move_iterator(blocks.end())
+  );
+}
+
+void TokenBlocks::assign(std::span<const Token> tokens) {
+  // Like `rebuild`, but into the blocks there are, keeping their entries.
+  size_ = tokens.size();
+  auto count = (size_ + block_size - 1) / block_size;
+  blocks_.resize(count);
+  for (usize i = 0; i < count; ++i) {
+    auto begin = size_ * i / count, end = size_ * (i + 1) / count;
+    auto &block = blocks_[i];
+    block.offset = span_of(tokens[begin]).offset;
+    block.first = begin;
+    block.entries.clear();
+    for (auto token : tokens.subspan(begin, end - begin)) {
+      set_offset(token, span_of(token).offset - block.offset);
+      block.entries.push_back({token});
+    }
+  }
+  hint_ = 0;
+}
+
+usize TokenBlocks::size() const {
+  return size_;
+}
+
+Token TokenBlocks::operator[](usize index) const {
+  const auto &block = blocks_[block_of(index)];
+  auto token = block.entries[index - block.first].token;
+  set_offset(token, block.offset + span_of(token).offset);
+  return token;
+}
+
+usize TokenBlocks::offset(usize index) const {
+  const auto &block = blocks_[block_of(index)];
+  return block.offset +
+         span_of(block.entries[index - block.first].token).offset;
+}
+
+usize TokenBlocks::find(usize offset) const {
+  auto ends_before = [&](const Block &block, const Entry &entry) {
+    auto span = span_of(entry.token);
+    return block.offset + span.offset + span.length < offset;
+  };
+  auto block = std::partition_point(
+      blocks_.begin(), blocks_.end(),
+      [&](const Block &block) {
+        return ends_before(block, block.entries.back());
+      }
+  );
+  if (block == blocks_.end())
+    return size_;
+  return block->first +
+         static_cast<usize>(
+             std::partition_point(
+                 block->entries.begin(), block->entries.end(),
+                 [&](const Entry &entry) {
+                   return ends_before(*block, entry);
+                 }
+             ) -
+             block->entries.begin()
+         );
+}
+
+u32 TokenBlocks::checkpoint(usize index) const {
+  if (index == size_)
+    return end_checkpoint_;
+  const auto &block = blocks_[block_of(index)];
+  return block.entries[index - block.first].checkpoint;
+}
+
+void TokenBlocks::set_checkpoint(usize index, u32 checkpoint) {
+  if (index == size_) {
+    end_checkpoint_ = checkpoint;
+    return;
+  }
+  auto &block = blocks_[block_of(index)];
+  block.entries[index - block.first].checkpoint = checkpoint;
+}
+
+void TokenBlocks::replace(
+    usize index, usize count, std::span<const Token> tokens, isize shift
+) {
+  auto moved = [&](usize offset) {
+    return static_cast<usize>(static_cast<isize>(offset) + shift);
+  };
+  // Appends the entries of `block` to `spliced_`, at their offsets in the
+  // source moved by `block_shift`.
+  auto append = [&](const Block &block, isize block_shift) {
+    for (auto entry : block.entries) {
+      set_offset(
+          entry.token, static_cast<usize>(
+                           static_cast<isize>(
+                               block.offset + span_of(entry.token).offset
+                           ) +
+                           block_shift
+                       )
+      );
+      spliced_.push_back(entry);
+    }
+  };
+  auto added = static_cast<isize>(tokens.size()) - static_cast<isize>(count);
+
+  // The blocks the range falls in.
+  usize from = 0, to = 0;
+  if (!blocks_.empty()) {
+    from = block_of(index);
+    to = block_of(count == 0 ? index : index + count - 1) + 1;
+  }
+  auto first = from < blocks_.size() ? blocks_[from].first : 0;
+  size_ = static_cast<usize>(static_cast<isize>(size_) + added);
+
+  // Within one block and past its first token, which keeps the offset of
+  // the block, the tokens are replaced in place.
+  if (to == from + 1 && index > first) {
+    auto &block = blocks_[from];
+    auto at = block.entries.begin() + static_cast<isize>(index - first);
+    at = block.entries.erase(at, at + static_cast<isize>(count));
+    for (auto it = at; it != block.entries.end(); ++it)
+      set_offset(it->token, moved(span_of(it->token).offset));
+    at = block.entries.insert(at, tokens.size(), Entry{});
+    for (const auto &token : tokens) {
+      at->token = token;
+      set_offset(at->token, span_of(token).offset - block.offset);
+      ++at;
+    }
+    for (auto i = to; i < blocks_.size(); ++i) {
+      blocks_[i].offset = moved(blocks_[i].offset);
+      blocks_[i].first =
+          static_cast<usize>(static_cast<isize>(blocks_[i].first) + added);
+    }
+    if (block.entries.size() > 2 * block_size) {
+      spliced_.clear();
+      append(block, 0);
+      rebuild(from, to, first);
+    }
+    return;
+  }
+
+  // Otherwise they are rebuilt, from the entries at their offsets in the
+  // edited source.
+  spliced_.clear();
+  for (auto i = from; i < to; ++i)
+    append(blocks_[i], 0);
+  auto at = spliced_.begin() + static_cast<isize>(index - first);
+  at = spliced_.erase(at, at + static_cast<isize>(count));
+  for (auto it = at; it != spliced_.end(); ++it)
+    set_offset(it->token, moved(span_of(it->token).offset));
+  at = spliced_.insert(at, tokens.size(), Entry{});
+  for (const auto &token : tokens)
+    (at++)->token = token;
+  // A block left small takes in the next one.
+  while (spliced_.size() < block_size / 2 && to < blocks_.size())
+    append(blocks_[to++], shift);
+
+  for (auto i = to; i < blocks_.size(); ++i) {
+    blocks_[i].offset = moved(blocks_[i].offset);
+    blocks_[i].first =
+        static_cast<usize>(static_cast<isize>(blocks_[i].first) + added);
+  }
+  rebuild(from, to, first);
+}
+
+std::vector<Token> TokenBlocks::to_vector() const {
+  std::vector<Token> tokens;
+  for (const auto &block : blocks_)
+    for (auto entry : block.entries) {
+      set_offset(entry.token, block.offset + span_of(entry.token).offset);
+      tokens.push_back(entry.token);
+    }
+  return tokens;
+}
+
+IncrementalParser::IncrementalParser(const CompiledGrammar &grammar):
+    grammar_(grammar) {
+  reset("");
+}
+
+bool IncrementalParser::same_stack(u32 lhs, u32 rhs) const {
+  // Two states share the nodes below the point where they diverged, so the
+  // walk ends there.
+  while (lhs != rhs) {
+    if (lhs == CheckpointStack::none || rhs == CheckpointStack::none)
+      return false;
+    const auto &lhs_node = nodes_[lhs];
+    const auto &rhs_node = nodes_[rhs];
+    if (lhs_node.depth != rhs_node.depth ||
+        lhs_node.symbol != rhs_node.symbol)
+      return false;
+    lhs = lhs_node.below;
+    rhs = rhs_node.below;
+  }
+  return true;
+}
+
+std::optional<Symbol> IncrementalParser::symbol_at(usize index) const {
+  if (index >= tokens_.size())
+    return Symbol::end_symbol();
+  return grammar_.lexeme_symbol(tokens_[index]);
+}
+
+void IncrementalParser::parse(
+    u32 top, usize start, usize match_from, usize old_match_from
+) {
+  CheckpointStack stack{nodes_, top};
+  reparsed_ = 0;
+
+  for (usize index = start;; ++index) {
+    if (index >= match_from) {
+      auto old_index = index - match_from + old_match_from;
+      if (old_index < checkpointed_ &&
+          same_stack(stack.top, tokens_.checkpoint(index))) {
+        // From here on the parse goes as before, and so does its outcome.
+        if (status_ == Status::Rejected)
+          error_index_ = error_index_ - old_index + index;
+        checkpointed_ = checkpointed_ - old_index + index;
+        return;
+      }
+    }
+    tokens_.set_checkpoint(index, stack.top);
+
+    auto symbol = symbol_at(index);
+    auto result = StepResult::Rejected;
+    if (symbol)
+      result = grammar_.visit_table([&](const auto &table) {
+        return ll1_step(table, *symbol, stack);
+      });
+    ++reparsed_;
+    if (result == StepResult::Shifted)
+      continue;
+    status_ =
+        result == StepResult::Accepted ? Status::Accepted : Status::Rejected;
+    error_index_ = index;
+    checkpointed_ = index + 1;
+    return;
+  }
+}
+
+IncrementalParser::Status IncrementalParser::reset(std::string_view src) {
+  src_.assign(src);
+  lexed_.clear();
+  relexed_ = 0;
+  Lexer lexer(src_);
+  for (std::optional<Token> token; (token = lexer.next_token());) {
+    ++relexed_;
+    if (!std::holds_alternative<Whitespace>(*token))
+      lexed_.push_back(*token);
+  }
+  tokens_.assign(lexed_);
+
+  nodes_.reset();
+  CheckpointStack stack{nodes_};
+  stack.push_back(Symbol::end_symbol());
+  stack.push_back(grammar_.start_symbol());
+  parse(stack.top, 0, ~usize{}, 0);
+  baseline_nodes_ = nodes_.size();
+  return status_;
+}
+
+IncrementalParser::Status IncrementalParser::edit(
+    usize offset, usize removed, std::string_view inserted
+) {
+  if (offset > src_.size() || removed > src_.size() - offset)
+    throw std::runtime_error(std::format(
+        "Edit of {} bytes at {} is out of a source of {} bytes", removed,
+        offset, src_.size()
+    ));
+  src_.replace(offset, removed, inserted);
+
+  // The first token touching the edit, or ending where it starts as it may
+  // run on into it, and the first one past the removed bytes, the earliest
+  // the old tokens can resume at.
+  auto a = tokens_.find(offset);
+  auto b = a;
+  while (b < tokens_.size() && tokens_.offset(b) < offset + removed)
+    ++b;
+  auto shifted = [&](usize index) {
+    return tokens_.offset(index) - removed + inserted.size();
+  };
+
+  // Lex from there up to a token starting where an old one now does; the
+  // old tokens go on from that one unchanged.
+  auto lex_from =
+      a < tokens_.size() ? std::min(tokens_.offset(a), offset) : offset;
+  lexed_.clear();
+  relexed_ = 0;
+  Lexer lexer(std::string_view(src_).substr(lex_from));
+  bool resumed = false;
+  for (std::optional<Token> token; (token = lexer.next_token());) {
+    ++relexed_;
+    auto at = lex_from + span_of(*token).offset;
+    while (b < tokens_.size() && shifted(b) < at)
+      ++b;
+    if (b < tokens_.size() && shifted(b) == at) {
+      resumed = true;
+      break;
+    }
+    if (std::holds_alternative<Whitespace>(*token))
+      continue;
+    set_offset(*token, at);
+    lexed_.push_back(*token);
+  }
+  if (!resumed)
+    b = tokens_.size();
+
+  // A parse rejected before the edit resumes from the rejected token.
+  auto start = std::min(a, checkpointed_ - 1);
+  auto top = tokens_.checkpoint(start);
+  tokens_.replace(
+      a, b - a, lexed_,
+      static_cast<isize>(inserted.size()) - static_cast<isize>(removed)
+  );
+  parse(top, start, a + lexed_.size(), b);
+
+  // Every edit leaves the nodes of the stacks it replaced behind; parsing
+  // from scratch now and then drops them.
+  if (nodes_.size() > 4 * baseline_nodes_ + 4096) {
+    auto relexed = relexed_, reparsed = reparsed_;
+    auto src = std::move(src_);
+    reset(src);
+    relexed_ = relexed;
+    reparsed_ = reparsed;
+  }
+  return status_;
+}
+
+IncrementalParser::Status IncrementalParser::status() const {
+  return status_;
+}
+
+usize IncrementalParser::error_offset() const {
+  return error_index_ < tokens_.size() ? tokens_.offset(error_index_)
+                                       : src_.size();
+}
+
+std::string_view IncrementalParser::source() const {
+  return src_;
+}
+
+std::vector<Token> IncrementalParser::token_stream() const {
+  return tokens_.to_vector();
+}
+
+usize IncrementalParser::relexed() const {
+  return relexed_;
+}
+
+usize IncrementalParser::reparsed() const {
+  return reparsed_;
+}
+
+} // namespace ep
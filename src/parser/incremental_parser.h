@@ -0,0 +1,194 @@
+#pragma once
+
+#ifndef EP_PARSER_INCREMENTAL_PARSER_H
+#  define EP_PARSER_INCREMENTAL_PARSER_H
+
+#  include "parser/parser.h"
+#  include "simple_lexer/token.h"
+#  include "util/arena.h"
+#  include "util/type.h"
+
+#  include <optional>
+#  include <span>
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace ep {
+
+// LL stack whose states share their nodes: pushing links a new node to the
+// one below and popping follows that link, so that a state is the index of
+// its top node and saving one costs nothing. Nodes are never freed, only
+// dropped all at once with the arena.
+struct CheckpointStack {
+  static constexpr u32 none = ~u32{};
+
+  struct Node {
+    Symbol symbol{};
+    u32 below{none};
+    u32 depth{};
+  };
+
+  Arena<Node> &nodes;
+  u32 top{none};
+
+  [[nodiscard]] bool empty() const {
+    return top == none;
+  }
+
+  [[nodiscard]] Symbol back() const {
+    return nodes[top].symbol;
+  }
+
+  void pop_back() {
+    top = nodes[top].below;
+  }
+
+  void push_back(Symbol symbol) {
+    top = nodes.allocate({symbol, top, empty() ? 1 : nodes[top].depth + 1});
+  }
+};
+
+// The tokens of a source, each with the checkpoint before it, in blocks of
+// consecutive ones. Token offsets are relative to their block, so that
+// replacing a range of tokens rewrites the blocks it falls in, and of each
+// block past them only its offset and first index: the cost of an edit is
+// that of a block or two and of the block list, not of the tokens past it.
+class TokenBlocks {
+public:
+  static constexpr usize block_size = 256;
+
+private:
+  struct Entry {
+    Token token; // Its offset relative to the block.
+    u32 checkpoint{CheckpointStack::none};
+  };
+
+  struct Block {
+    usize offset{}; // Of the first token in the source.
+    usize first{};  // Index of the first token.
+    std::vector<Entry> entries{};
+  };
+
+  // None of them empty.
+  std::vector<Block> blocks_{};
+  usize size_{};
+  u32 end_checkpoint_{CheckpointStack::none};
+  // The block `block_of` found last.
+  mutable usize hint_{};
+  // The entries of the blocks being rewritten, at their offsets in the
+  // source.
+  std::vector<Entry> spliced_{};
+
+  // The block of token `index`, or the last one past the last token.
+  [[nodiscard]] usize block_of(usize index) const;
+
+  // Replaces blocks `from` to `to` by blocks of the entries in `spliced_`,
+  // the first of which is token `first`.
+  void rebuild(usize from, usize to, usize first);
+
+public:
+  void assign(std::span<const Token> tokens);
+
+  [[nodiscard]] usize size() const;
+
+  // Token `index`, at its offset in the source.
+  [[nodiscard]] Token operator[](usize index) const;
+
+  [[nodiscard]] usize offset(usize index) const;
+
+  // The index of the first token that ends at `offset` or past it.
+  [[nodiscard]] usize find(usize offset) const;
+
+  // The checkpoint before token `index`, or before `$` at `size()`.
+  [[nodiscard]] u32 checkpoint(usize index) const;
+
+  void set_checkpoint(usize index, u32 checkpoint);
+
+  // Replaces the `count` tokens at `index` by `tokens`, at their offsets in
+  // the edited source, and shifts the tokens past them by `shift` bytes.
+  // The new tokens have no checkpoint; the others keep theirs.
+  void replace(
+      usize index, usize count, std::span<const Token> tokens, isize shift
+  );
+
+  [[nodiscard]] std::vector<Token> to_vector() const;
+};
+
+// Recognizes one expression that is edited in place, as in a formula
+// editor. The LL stack before every token is kept as a checkpoint. An edit
+// re-lexes only the tokens it touches, resumes the parse from the
+// checkpoint before the first of them, and stops as soon as the stack
+// matches the checkpoint of the previous parse at the same token again,
+// since from there on the parse can only go as before. The lexing and
+// parsing of an edit thus depend on the reach of the edit, not on the
+// length of the source, and so does updating the tokens, kept in
+// `TokenBlocks`; only the source itself is one string.
+class IncrementalParser {
+public:
+  enum class Status {
+    Accepted,
+    Rejected, // See `error_offset`.
+  };
+
+private:
+  const CompiledGrammar &grammar_;
+  std::string src_{};
+  // The tokens of `src_`, whitespace excluded and lex errors included,
+  // with the stack before each.
+  TokenBlocks tokens_{};
+  std::vector<Token> lexed_{};
+  Arena<CheckpointStack::Node> nodes_{};
+  // The number of tokens from the first whose checkpoints are those of the
+  // last parse: up to the token that was rejected, or all of them and the
+  // one before the closing `$`.
+  usize checkpointed_{};
+  // Nodes in use after the last parse from scratch.
+  usize baseline_nodes_{};
+  Status status_{Status::Rejected};
+  usize error_index_{};
+  usize relexed_{};
+  usize reparsed_{};
+
+  [[nodiscard]] bool same_stack(u32 lhs, u32 rhs) const;
+
+  // The terminator of the token at `index`, or `$` past the last one.
+  [[nodiscard]] std::optional<Symbol> symbol_at(usize index) const;
+
+  // Parses on from the stack `top` before token `start`. From token
+  // `match_from` on, which was token `old_match_from` of the previous
+  // parse, it stops where the stack matches the old checkpoint, which the
+  // token still carries.
+  void parse(u32 top, usize start, usize match_from, usize old_match_from);
+
+public:
+  // `grammar` must outlive the parser.
+  explicit IncrementalParser(const CompiledGrammar &grammar);
+
+  // Parses `src` from scratch.
+  Status reset(std::string_view src);
+
+  // Replaces the `removed` bytes at `offset` by `inserted` and parses the
+  // result. Throws `std::runtime_error` if the range is out of the source.
+  Status edit(usize offset, usize removed, std::string_view inserted);
+
+  [[nodiscard]] Status status() const;
+
+  // Byte offset of the token that was rejected; the length of the source if
+  // it ended too early.
+  [[nodiscard]] usize error_offset() const;
+
+  [[nodiscard]] std::string_view source() const;
+
+  // A copy of the tokens, at their offsets in the source.
+  [[nodiscard]] std::vector<Token> token_stream() const;
+
+  // The tokens lexed and the symbols shifted by the last call.
+  [[nodiscard]] usize relexed() const;
+
+  [[nodiscard]] usize reparsed() const;
+};
+
+} // namespace ep
+
+#endif // EP_PARSER_INCREMENTAL_PARSER_H
@@ -0,0 +1,103 @@
+#include "parser/metrics.h"
+
+#include <algorithm>
+#include <format>
+
+namespace ep {
+
+void Metrics::record_phase(std::string_view name, double seconds) {
+  auto it = std::find_if(phases_.begin(), phases_.end(), [&](const auto &p) {
+    return p.first == name;
+  });
+  if (it == phases_.end())
+    phases_.emplace_back(name, seconds);
+  else
+    it->second += seconds;
+}
+
+void Metrics::record_parse(
+    const ParseCounters &counters, bool accepted, u64 nanoseconds
+) {
+  counters_ += counters;
+  ++parses_;
+  accepted_ += accepted;
+  latency_.record(nanoseconds);
+}
+
+void Metrics::merge(const Metrics &rhs) {
+  for (const auto &[name, seconds] : rhs.phases_)
+    record_phase(name, seconds);
+  counters_ += rhs.counters_;
+  parses_ += rhs.parses_;
+  accepted_ += rhs.accepted_;
+  latency_.merge(rhs.latency_);
+}
+
+const std::vector<std::pair<std::string, double>> &Metrics::phases() const {
+  return phases_;
+}
+
+double Metrics::phase(std::string_view name) const {
+  auto it = std::find_if(phases_.begin(), phases_.end(), [&](const auto &p) {
+    return p.first == name;
+  });
+  return it == phases_.end() ? 0 : it->second;
+}
+
+const ParseCounters &Metrics::counters() const {
+  return counters_;
+}
+
+u64 Metrics::parses() const {
+  return parses_;
+}
+
+u64 Metrics::accepted() const {
+  return accepted_;
+}
+
+const LatencyHistogram &Metrics::latency() const {
+  return latency_;
+}
+
+std::string Metrics::to_json() const {
+  std::string buf = "{\n  \"phases_us\": {";
+  for (usize i = 0; i < phases_.size(); ++i)
+    buf += std::format(
+        "{}\n    \"{}\": {:.3f}", i == 0 ? "" : ",", phases_[i].first,
+        phases_[i].second * 1e6
+    );
+  buf += phases_.empty() ? "},\n" : "\n  },\n";
+  buf += std::format(
+      "  \"parses\": {},\n  \"accepted\": {},\n"
+      "  \"counters\": {{\n    \"tokens\": {},\n    \"expansions\": {},\n"
+      "    \"matches\": {},\n    \"recoveries\": {},\n"
+      "    \"max_stack_depth\": {}\n  }},\n",
+      parses_, accepted_, counters_.tokens, counters_.expansions,
+      counters_.matches, counters_.recoveries, counters_.max_stack_depth
+  );
+  buf += std::format(
+      "  \"latency_ns\": {{\n    \"p50\": {},\n    \"p99\": {},\n"
+      "    \"max\": {}\n  }}\n}}\n",
+      latency_.percentile(0.5), latency_.percentile(0.99), latency_.max()
+  );
+  return buf;
+}
+
+PhaseTimer::PhaseTimer(Metrics *metrics, std::string_view name):
+    metrics_(metrics), name_(name) {
+  if (metrics_)
+    start_ = std::chrono::steady_clock::now();
+}
+
+PhaseTimer::~PhaseTimer() {
+  if (metrics_)
+    metrics_->record_phase(
+        name_, std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start_
+               )
+                   .count()
+    );
+}
+
+} // namespace ep
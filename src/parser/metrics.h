@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef EP_PARSER_METRICS_H
+#  define EP_PARSER_METRICS_H
+
+#  include "parser/driver.h"
+#  include "util/histogram.h"
+#  include "util/type.h"
+
+#  include <chrono>
+#  include <string>
+#  include <string_view>
+#  include <utility>
+#  include <vector>
+
+namespace ep {
+
+// Opt-in measurements of the pipeline: the wall time of each grammar phase,
+// the counters of every parse summed, and the latency of each input. A
+// component records into a `Metrics` only when handed a pointer to one, so
+// that without it nothing is timed or counted. Not synchronized: give each
+// thread its own and `merge` them.
+class Metrics {
+  std::vector<std::pair<std::string, double>> phases_{};
+  ParseCounters counters_{};
+  u64 parses_{};
+  u64 accepted_{};
+  LatencyHistogram latency_{};
+
+public:
+  // Adds `seconds` to phase `name`, which is listed in order of first use.
+  void record_phase(std::string_view name, double seconds);
+
+  void record_parse(
+      const ParseCounters &counters, bool accepted, u64 nanoseconds
+  );
+
+  void merge(const Metrics &rhs);
+
+  [[nodiscard]] const std::vector<std::pair<std::string, double>> &
+  phases() const;
+
+  // Seconds spent in phase `name`, 0 if it never ran.
+  [[nodiscard]] double phase(std::string_view name) const;
+
+  [[nodiscard]] const ParseCounters &counters() const;
+
+  [[nodiscard]] u64 parses() const;
+
+  [[nodiscard]] u64 accepted() const;
+
+  [[nodiscard]] const LatencyHistogram &latency() const;
+
+  [[nodiscard]] std::string to_json() const;
+};
+
+// Records the time from its construction to its destruction as a phase of
+// `metrics`, if not null.
+class PhaseTimer {
+  Metrics *metrics_;
+  std::string_view name_;
+  std::chrono::steady_clock::time_point start_{};
+
+public:
+  PhaseTimer(Metrics *metrics, std::string_view name);
+
+  PhaseTimer(const PhaseTimer &rhs) = delete;
+
+  PhaseTimer &operator=(const PhaseTimer &rhs) = delete;
+
+  ~PhaseTimer();
+};
+
+} // namespace ep
+
+#endif // EP_PARSER_METRICS_H
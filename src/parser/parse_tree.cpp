@@ -0,0 +1,251 @@
+#include "parser/parse_tree.h"
+
+#include <algorithm>
+
+namespace ep {
+
+void Tree::reset() {
+  nodes.reset();
+  root = TreeNode::none;
+}
+
+u32 Tree::push(const TreeNode &node) {
+  return nodes.allocate(node);
+}
+
+std::string to_string(const Tree &tree, const SymbolTable &symbols) {
+  std::string buf;
+  TreeScratch scratch;
+  append_string(tree, symbols, buf, scratch);
+  return buf;
+}
+
+// Pre-order. A node with children leaves its closing parenthesis on the
+// stack under them; every node but the root is preceded by a space.
+void append_string(
+    const Tree &tree, const SymbolTable &symbols, std::string &buf,
+    TreeScratch &scratch
+) {
+  if (tree.root == TreeNode::none) {
+    buf.append("(nul)");
+    return;
+  }
+
+  auto &walk = scratch.walk;
+  walk.clear();
+  walk.push_back(tree.root);
+  for (bool is_root = true; !walk.empty(); is_root = false) {
+    auto node = walk.back();
+    walk.pop_back();
+    if (node == TreeNode::none) {
+      buf.append(1, ')');
+      continue;
+    }
+    if (!is_root)
+      buf.append(1, ' ');
+
+    const auto &[symbol, _, first_child, __] = tree.nodes[node];
+    if (first_child == TreeNode::none) {
+      buf.append(symbols.to_string(symbol));
+      continue;
+    }
+    buf.append(1, '(').append(symbols.to_string(symbol));
+    walk.push_back(TreeNode::none);
+    auto children = walk.size();
+    for (auto child = first_child; child != TreeNode::none;
+         child = tree.nodes[child].next_sibling)
+      walk.push_back(child);
+    std::reverse(walk.begin() + static_cast<isize>(children), walk.end());
+  }
+}
+
+ParseTreeBuilder::ParseTreeBuilder(Tree &tree, TreeScratch &scratch):
+    tree_(tree), pending_(scratch.pending) {}
+
+void ParseTreeBuilder::expand(
+    u32 production, std::span<const Symbol> prediction
+) {
+  auto node = pending_.back();
+  pending_.pop_back();
+  tree_.nodes[node].value = production;
+
+  auto pending_size = pending_.size();
+  auto previous = TreeNode::none;
+  for (const auto &symbol : prediction) {
+    auto child = tree_.push({symbol});
+    if (previous == TreeNode::none)
+      tree_.nodes[node].first_child = child;
+    else
+      tree_.nodes[previous].next_sibling = child;
+    pending_.push_back(previous = child);
+  }
+  std::reverse(pending_.begin() + pending_size, pending_.end());
+}
+
+namespace {
+
+class AstBuilder {
+  using Item = TreeScratch::Item;
+  using Frame = TreeScratch::Frame;
+
+  const Tree &parse_tree_;
+  const SymbolTable &symbols_;
+  Tree &ast_;
+  std::vector<Item> &items_;
+  std::vector<Frame> &frames_;
+
+public:
+  AstBuilder(
+      const Tree &parse_tree, const SymbolTable &symbols, Tree &ast,
+      TreeScratch &scratch
+  ):
+      parse_tree_(parse_tree), symbols_(symbols), ast_(ast),
+      items_(scratch.items), frames_(scratch.frames) {}
+
+  // The AST of `root`. A `Build` of a node flattens it, which pushes the
+  // items of its children: its terminators, and the AST of each child
+  // from the source grammar, built first by a `Build` of its own. The
+  // children of left factoring helpers are flattened in place, and a left
+  // recursion helper is left for the `Build` to fold: for `A -> β A'` and
+  // `A' -> α A' | ε`, each `A'` folds `acc α` into a new `acc`. A finished
+  // frame leaves its result, an AST node or a helper, in `result`.
+  u32 build(u32 root) {
+    frames_.clear();
+    start_build(root);
+    auto result = TreeNode::none;
+    bool returned = false;
+    while (!frames_.empty()) {
+      auto &frame = frames_.back();
+      if (frame.kind == Frame::Build) {
+        // Only ever resumed by the `Flatten` of its node, with the helper
+        // that node left.
+        auto acc = make_node(frame.mark, parse_tree_.nodes[frame.node].symbol);
+        if (result == TreeNode::none) {
+          frames_.pop_back();
+          result = acc;
+          continue;
+        }
+        if (acc != TreeNode::none)
+          items_.push_back({true, acc});
+        frame.node = result;
+        start_flatten(result);
+        returned = false;
+        continue;
+      }
+
+      if (returned) {
+        // `frame.node` is the child whose frame just finished.
+        if (symbols_.origin(parse_tree_.nodes[frame.node].symbol) ==
+            SymbolOrigin::Source) {
+          if (result != TreeNode::none)
+            items_.push_back({true, result});
+        } else if (result != TreeNode::none) {
+          frame.tail = result;
+        }
+        frame.node = parse_tree_.nodes[frame.node].next_sibling;
+        returned = false;
+      }
+      if (!flatten(frame)) {
+        result = frame.tail;
+        frames_.pop_back();
+        returned = true;
+      }
+    }
+    return result;
+  }
+
+private:
+  void start_build(u32 node) {
+    frames_.push_back({Frame::Build, node, static_cast<u32>(items_.size())});
+    start_flatten(node);
+  }
+
+  void start_flatten(u32 node) {
+    frames_.push_back({Frame::Flatten, parse_tree_.nodes[node].first_child});
+  }
+
+  // Visits the children of `frame` from `frame.node` on, until one needs a
+  // frame of its own, which is pushed; false if none is left.
+  bool flatten(Frame &frame) {
+    for (; frame.node != TreeNode::none;
+         frame.node = parse_tree_.nodes[frame.node].next_sibling) {
+      auto child = frame.node;
+      auto symbol = parse_tree_.nodes[child].symbol;
+      if (symbol.type == Symbol::Terminator) {
+        if (symbol != Symbol::empty_symbol())
+          items_.push_back({false, child});
+        continue;
+      }
+
+      switch (symbols_.origin(symbol)) {
+        case SymbolOrigin::LeftFactoring:
+          start_flatten(child);
+          return true;
+        case SymbolOrigin::LeftRecursion:
+          frame.tail = child;
+          break;
+        case SymbolOrigin::Source:
+          start_build(child);
+          return true;
+      }
+    }
+    return false;
+  }
+
+  // Builds a node from the items pushed since `mark` and pops them.
+  u32 make_node(usize mark, Symbol lhs) {
+    auto items = std::span(items_).subspan(mark);
+
+    usize operand_count = 0;
+    const Item *label = nullptr;
+    for (const auto &item : items) {
+      if (item.is_operand)
+        ++operand_count;
+      else if (!label)
+        label = &item;
+    }
+
+    auto node = TreeNode::none;
+    if (!label && operand_count == 1)
+      node = items.front().node;
+    else if (operand_count == 1 && items.size() == 3 &&
+             !items.front().is_operand && !items.back().is_operand)
+      node = items[1].node;
+    else if (label || operand_count > 0) {
+      node = ast_.push(
+          label ? TreeNode{parse_tree_.nodes[label->node].symbol,
+                           parse_tree_.nodes[label->node].value}
+                : TreeNode{lhs}
+      );
+      auto previous = TreeNode::none;
+      for (const auto &item : items) {
+        if (!item.is_operand)
+          continue;
+        if (previous == TreeNode::none)
+          ast_.nodes[node].first_child = item.node;
+        else
+          ast_.nodes[previous].next_sibling = item.node;
+        previous = item.node;
+      }
+    }
+
+    items_.resize(mark);
+    return node;
+  }
+};
+
+} // namespace
+
+void build_ast(
+    const Tree &parse_tree, const SymbolTable &symbols, Tree &ast,
+    TreeScratch &scratch
+) {
+  ast.reset();
+  if (parse_tree.root == TreeNode::none)
+    return;
+  scratch.items.clear();
+  ast.root =
+      AstBuilder(parse_tree, symbols, ast, scratch).build(parse_tree.root);
+}
+
+} // namespace ep
@@ -0,0 +1,148 @@
+#pragma once
+
+#ifndef EP_PARSER_PARSE_TREE_H
+#  define EP_PARSER_PARSE_TREE_H
+
+#  include "parser/driver.h"
+#  include "parser/grammar.h"
+#  include "util/arena.h"
+
+#  include <span>
+#  include <string>
+#  include <vector>
+
+namespace ep {
+
+// Node of a parse tree or an AST. Children are linked through indices into
+// the arena of the owning `Tree`.
+struct TreeNode {
+  static constexpr u32 none = ~u32{};
+
+  Symbol symbol{};
+  // Production index for a nonterminator of a parse tree, otherwise the input
+  // position of the terminator (`none` for the empty symbol).
+  u32 value{none};
+  u32 first_child{none};
+  u32 next_sibling{none};
+};
+
+struct Tree {
+  Arena<TreeNode> nodes{};
+  u32 root{TreeNode::none};
+
+  void reset();
+
+  u32 push(const TreeNode &node);
+};
+
+// Scratch space of `ParseTreeBuilder`, `build_ast` and `append_string`. A
+// caller building many trees keeps one and hands it to each, so that once
+// it has grown to the largest tree it is only reused. The trees are walked
+// with these explicit stacks rather than by recursion, so that no depth of
+// nesting can overflow the call stack.
+struct TreeScratch {
+  // A child kept for an AST node: either an already built AST node, or a
+  // terminator of the parse tree.
+  struct Item {
+    bool is_operand;
+    u32 node;
+  };
+
+  // A suspended step of `build_ast`.
+  struct Frame {
+    enum Kind : u8 {
+      Build,   // Folds the items from `mark` on into the AST of `node`.
+      Flatten, // Pushes the items of the children of a node, from `node` on.
+    };
+
+    Kind kind;
+    u32 node;
+    u32 mark{};
+    // The left recursion helper child found so far by a `Flatten`.
+    u32 tail{TreeNode::none};
+  };
+
+  // The parse tree nodes of the symbols on the LL stack.
+  std::vector<u32> pending{};
+  std::vector<Item> items{};
+  std::vector<Frame> frames{};
+  // The nodes left to print, `TreeNode::none` closing a parenthesis.
+  std::vector<u32> walk{};
+};
+
+[[nodiscard]] std::string
+to_string(const Tree &tree, const SymbolTable &symbols);
+
+// Appends `to_string(tree, symbols)` to `buf`.
+void append_string(
+    const Tree &tree, const SymbolTable &symbols, std::string &buf,
+    TreeScratch &scratch
+);
+
+// Observer for `ll1_parse` building the concrete parse tree of the input.
+// Nonterminators are labelled with the production expanded, terminators
+// with their input position. Parsing stops at the first error, leaving
+// `tree.root` unset; until then every terminator popped has matched the
+// next input symbol, so the positions are counted rather than read from
+// the input.
+class ParseTreeBuilder : public Recognizer {
+  Tree &tree_;
+  std::vector<u32> &pending_;
+  u32 matched_{};
+
+public:
+  ParseTreeBuilder(Tree &tree, TreeScratch &scratch);
+
+  void initial(const std::vector<Symbol> &stack, auto) {
+    tree_.reset();
+    pending_.clear();
+    pending_.push_back(TreeNode::none); // Stands for the bottom `$`.
+    pending_.push_back(tree_.root = tree_.push({stack.back()}));
+    matched_ = 0;
+  }
+
+  void popped(const std::vector<Symbol> &, auto) {
+    auto node = pending_.back();
+    pending_.pop_back();
+    if (node != TreeNode::none &&
+        tree_.nodes[node].symbol != Symbol::empty_symbol())
+      tree_.nodes[node].value = matched_++;
+  }
+
+  void expanded(
+      const std::vector<Symbol> &, auto, Symbol, u32 production,
+      std::span<const Symbol> prediction
+  ) {
+    expand(production, prediction);
+  }
+
+  void mismatched(Symbol, Symbol) {
+    tree_.root = TreeNode::none;
+  }
+
+  void skipped(Symbol, Symbol) {
+    tree_.root = TreeNode::none;
+  }
+
+  void exhausted(Symbol) {
+    tree_.root = TreeNode::none;
+  }
+
+private:
+  void expand(u32 production, std::span<const Symbol> prediction);
+};
+
+// Folds a parse tree into an AST over the original grammar. Helper
+// nonterminators from left factoring are spliced into their parent, and the
+// chains of those from left recursion are folded back into left-associative
+// nodes. Every remaining node is labelled with its first terminator (e.g. the
+// operator) and has its operands as children; unit nodes and a lone operand
+// wrapped in terminators (e.g. `( E )`) collapse into that operand.
+void build_ast(
+    const Tree &parse_tree, const SymbolTable &symbols, Tree &ast,
+    TreeScratch &scratch
+);
+
+} // namespace ep
+
+#endif // EP_PARSER_PARSE_TREE_H
@@ -1,7 +1,9 @@
 #include "parser/parser.h"
 
+#include <chrono>
 #include <format>
 #include <iostream>
+#include <iterator>
 #include <stack>
 #include <stdexcept>
 #include <string>
@@ -10,14 +12,23 @@ using namespace std::string_literals;
 
 namespace ep {
 
-Parser::Parser(Grammar grammar): grammar_(std::move(grammar)) {
+CompiledGrammar::CompiledGrammar(Grammar grammar, Metrics *metrics):
+    grammar_(std::move(grammar)) {
+  // Runs one phase under a timer, leaving the printing out of it.
+  auto timed = [&](std::string_view phase, auto &&f) {
+    PhaseTimer timer(metrics, phase);
+    return f();
+  };
+
   std::cout << std::format(
                    "\033[32m-- Input grammar_ --\033[0m\n{}\n",
                    grammar_.to_string()
                )
             << std::endl;
 
-  grammar_.eliminate_left_recursion();
+  timed("left_recursion", [&] {
+    grammar_.eliminate_left_recursion();
+  });
   std::cout
       << std::format(
              "\033[32m-- Grammar eliminated left recursion --\033[0m\n{}\n",
@@ -25,7 +36,9 @@ Parser::Parser(Grammar grammar): grammar_(std::move(grammar)) {
          )
       << std::endl;
 
-  grammar_.extract_left_factoring();
+  timed("left_factoring", [&] {
+    grammar_.extract_left_factoring();
+  });
   std::cout
       << std::format(
              "\033[32m-- Grammar extracted left factoring --\033[0m\n{}\n",
@@ -33,22 +46,29 @@ Parser::Parser(Grammar grammar): grammar_(std::move(grammar)) {
          )
       << std::endl;
 
-  auto first_set = grammar_.build_first_set();
+  auto first_set = timed("first_set", [&] {
+    return grammar_.build_first_set();
+  });
   std::cout << std::format(
                    "\033[32m-- FIRST SET --\033[0m\n{}\n",
-                   to_string(first_set, "FIRST")
+                   to_string(first_set, "FIRST", grammar_.symbols)
                )
             << std::endl;
 
-  auto follow_set =
-      grammar_.build_follow_set(first_set, Symbol{"E", Symbol::NonTerminator});
+  start_symbol_ = grammar_.symbols.intern("E", Symbol::NonTerminator);
+  auto follow_set = timed("follow_set", [&] {
+    return grammar_.build_follow_set(first_set, start_symbol_);
+  });
   std::cout << std::format(
                    "\033[32m-- FOLLOW SET --\033[0m\n{}\n",
-                   to_string(follow_set, "FOLLOW")
+                   to_string(follow_set, "FOLLOW", grammar_.symbols)
                )
             << std::endl;
 
-  if (auto opt = grammar_.is_ll1(first_set, follow_set); opt) {
+  if (auto opt = timed("ll1_check", [&] {
+        return grammar_.is_ll1(first_set, follow_set);
+      });
+      opt) {
     std::cout << std::format(
                      "\033[32m-- Grammar is not LL(1) --\033[0m\n{}\n", *opt
                  )
@@ -60,186 +80,391 @@ Parser::Parser(Grammar grammar): grammar_(std::move(grammar)) {
                )
             << std::endl;
 
-  prediction_table_ = grammar_.build_prediction_table(first_set, follow_set);
+  prediction_table_ = timed("prediction_table", [&] {
+    return grammar_.build_prediction_table(first_set, follow_set);
+  });
   std::cout << std::format(
                    "\033[32m-- Prediction table --\033[0m\n{}\n",
-                   to_string(prediction_table_)
+                   to_string(prediction_table_, grammar_.symbols)
                )
             << std::endl;
+
+  resolve_lexeme_symbols(grammar_.symbols);
 }
 
-void Parser::load_source(std::string src) {
-  lexer_ = Lexer(std::move(src));
+CompiledGrammar::CompiledGrammar(
+    SymbolTable symbols, PredictionTable prediction_table, Symbol start_symbol
+):
+    prediction_table_(std::move(prediction_table)),
+    start_symbol_(start_symbol) {
+  grammar_.symbols = std::move(symbols);
+  resolve_lexeme_symbols(grammar_.symbols);
+}
 
-  std::vector<Token> token_stream;
-  for (std::optional<Token> token; (token = lexer_.next_token());) {
-    std::visit(
-        overloaded{
-            [](const LexError &) {
-              throw std::runtime_error("Lex error");
-            },
-            [](const Whitespace &) {},
-            [&](const auto &token) {
-              token_stream.push_back(token);
-            },
-        },
-        *token
-    );
-  }
+CompiledGrammar::CompiledGrammar(TableFile table_file):
+    table_file_(std::move(table_file)),
+    start_symbol_(table_file_->start_symbol()) {
+  resolve_lexeme_symbols(*table_file_);
+}
 
-  // std::cout << std::format("\033[32m-- Tokens --\033[0m\n");
-  // for (const auto &token : token_stream) {
-  //   std::visit(
-  //       overloaded{
-  //           [&](const Integer &) {
-  //             std::cout << "Integer, ";
-  //           },
-  //           [&](const Punctuator &token) {
-  //             std::cout << std::format("Punctuator(`{}`), ", token.punct);
-  //           },
-  //           [&](const auto &) {}},
-  //       token
-  //   );
-  // }
-  // std::cout << std::endl;
-
-  parse_expression(convert_lexeme_to_symbol(token_stream));
+template<class Symbols>
+void CompiledGrammar::resolve_lexeme_symbols(const Symbols &symbols) {
+  integer_symbol_ = symbols.find("n");
+  identifier_symbol_ = symbols.find("id");
+  for (char c : {'(', ')', '+', '-', '*', '/'})
+    if (auto symbol = symbols.find(std::string_view(&c, 1)); symbol)
+      punctuator_symbols_[static_cast<u8>(c)] = *symbol;
+  ops_ = ArithOpTable(symbols);
 }
 
 std::vector<Symbol>
-Parser::convert_lexeme_to_symbol(const std::vector<Token> &token_stream) {
+CompiledGrammar::convert_lexeme_to_symbol(const std::vector<Token> &token_stream
+) const {
   std::vector<Symbol> symbol_stream;
-  for (const auto &token : token_stream) {
-    std::visit(
-        overloaded{
-            [&](const Integer &) {
-              symbol_stream.emplace_back(
-                  "n", Symbol::Terminator
-              ); // Change here
-            },
-            [&](const Punctuator &token) {
-              symbol_stream.emplace_back(
-                  std::string(1, token.punct), Symbol::Terminator
-              );
-            },
-            [&](const auto &) {}},
-        token
-    );
-  }
+  symbol_stream.reserve(token_stream.size() + 1);
+  convert_lexeme_to_symbol(token_stream, symbol_stream);
   return symbol_stream;
 }
 
-inline std::string seq_to_string(auto begin, auto end) {
+void CompiledGrammar::convert_lexeme_to_symbol(
+    const std::vector<Token> &token_stream, std::vector<Symbol> &symbol_stream
+) const {
+  symbol_stream.clear();
+  for (const auto &token : token_stream)
+    if (!std::holds_alternative<Whitespace>(token) &&
+        !std::holds_alternative<LexError>(token))
+      symbol_stream.push_back(lexeme_terminator(token));
+}
+
+Symbol CompiledGrammar::lexeme_terminator(const Token &token) const {
+  return std::visit(
+      overloaded{
+          [&](const Integer &) {
+            if (!integer_symbol_)
+              throw std::runtime_error("Unknown terminator `n`");
+            return *integer_symbol_;
+          },
+          [&](const Identifier &) {
+            if (!identifier_symbol_)
+              throw std::runtime_error("Unknown terminator `id`");
+            return *identifier_symbol_;
+          },
+          [&](const Punctuator &token) {
+            const auto &symbol =
+                punctuator_symbols_[static_cast<u8>(token.punct)];
+            if (!symbol)
+              throw std::runtime_error(
+                  std::format("Unknown terminator `{}`", token.punct)
+              );
+            return *symbol;
+          },
+          [](const auto &) -> Symbol {
+            throw std::runtime_error("Not a lexeme");
+          }},
+      token
+  );
+}
+
+std::optional<Symbol> CompiledGrammar::lexeme_symbol(const Token &token) const {
+  return std::visit(
+      overloaded{
+          [&](const Integer &) {
+            return integer_symbol_;
+          },
+          [&](const Identifier &) {
+            return identifier_symbol_;
+          },
+          [&](const Punctuator &token) {
+            return punctuator_symbols_[static_cast<u8>(token.punct)];
+          },
+          [](const auto &) -> std::optional<Symbol> {
+            return std::nullopt;
+          }},
+      token
+  );
+}
+
+const SymbolTable &CompiledGrammar::symbols() const {
+  if (!table_file_)
+    return grammar_.symbols;
+  std::call_once(file_symbols_copied_, [&] {
+    file_symbols_ = table_file_->symbol_table();
+  });
+  return file_symbols_;
+}
+
+const PredictionTable &CompiledGrammar::prediction_table() const {
+  return prediction_table_;
+}
+
+Symbol CompiledGrammar::start_symbol() const {
+  return start_symbol_;
+}
+
+const ArithOpTable &CompiledGrammar::ops() const {
+  return ops_;
+}
+
+inline std::string
+seq_to_string(auto begin, auto end, const SymbolTable &symbols) {
   std::string buf;
   for (auto it = begin; it != end; ++it)
-    buf += it->to_string();
+    buf += symbols.to_string(*it);
   return buf;
 }
 
-inline std::string seq_to_string(const auto &seq) {
-  return seq_to_string(seq.begin(), seq.end());
+inline std::string seq_to_string(const auto &seq, const SymbolTable &symbols) {
+  return seq_to_string(seq.begin(), seq.end(), symbols);
 }
 
-void Parser::parse_expression(std::vector<Symbol> &&symbol_stream) {
-  symbol_stream.emplace_back("$", Symbol::Terminator);
+// Observer rendering every step of the parse as a row of the procedure
+// table printed by `parse_procedure_to_string`.
+struct TraceRecorder {
+  static constexpr bool stop_on_error = false;
 
-  // std::cout << std::format("\033[32m-- Symbols --\033[0m\n");
-  // for (const auto &symbol : symbol_stream)
-  //   std::cout << std::format("{}, ", symbol.to_string());
-  // std::cout << std::endl;
+  const SymbolTable &symbols;
+  std::span<const Symbol> input;
+  std::vector<CompiledGrammar::OutputEntry> &output_buffer;
 
-  bool has_error = false;
-  std::vector<OutputEntry> output_buffer{
-      {"<Stack>", "<Input>", "<Action>"}
-  };
+  void initial(const auto &stack, auto it) {
+    output_buffer.emplace_back(
+        seq_to_string(stack, symbols), seq_to_string(it, input.end(), symbols),
+        "Initial"
+    );
+  }
 
-  std::vector<Symbol> stack;
-  stack.emplace_back("$", Symbol::Terminator);
-  stack.emplace_back("E", Symbol::NonTerminator);
+  void popped(const auto &stack, auto it) {
+    output_buffer.emplace_back(
+        seq_to_string(stack, symbols), seq_to_string(it, input.end(), symbols),
+        ""
+    );
+  }
 
-  output_buffer.emplace_back(
-      seq_to_string(stack), seq_to_string(symbol_stream), "Initial"
-  );
+  void expanded(
+      const auto &stack, auto it, Symbol top, u32,
+      std::span<const Symbol> prediction
+  ) {
+    output_buffer.emplace_back(
+        seq_to_string(stack, symbols), seq_to_string(it, input.end(), symbols),
+        to_string({top, prediction}, symbols)
+    );
+  }
 
-  auto it = symbol_stream.begin();
-  while (!stack.empty()) {
-    auto top = stack.back();
-    stack.pop_back();
-
-    // if (it == symbol_stream.end()) {
-    //   std::cout << std::format(
-    //       "Not matched 3: {} != {}\n", top.to_string(),
-    //       Symbol::empty_symbol().to_string()
-    //   );
-    //   throw std::runtime_error("Not matched");
-    // }
-
-    if (top.type == Symbol::Terminator) {
-      if (top == Symbol::empty_symbol()) {
-        output_buffer.emplace_back(
-            seq_to_string(stack), seq_to_string(it, symbol_stream.end()), ""
-        );
-      } else if (top.v == it->v) {
-        ++it;
-        output_buffer.emplace_back(
-            seq_to_string(stack), seq_to_string(it, symbol_stream.end()), ""
-        );
-      } else {
-        has_error = true;
-        output_buffer.emplace_back(
-            "", "",
-            std::format(
-                "\033[31mError: {} not match {}\033[0m", top.to_string(),
-                it->to_string()
-            )
-        );
-      }
-    } else {
-      auto row = prediction_table_.at(top);
-      for (; it != symbol_stream.end() && !row.count(*it); ++it) {
-        has_error = true;
-        output_buffer.emplace_back(
-            "", "",
-            std::format(
-                "\033[31mError: {} not match {}\033[0m", top.to_string(),
-                it->to_string()
-            )
-        );
-      }
-      if (it == symbol_stream.end()) {
-        has_error = true;
-        output_buffer.emplace_back(
-            "", "",
-            std::format(
-                "\033[31mError: {} not match {}\033[0m", top.to_string(),
-                Symbol::empty_symbol().to_string()
-            )
-        );
-        break;
-      }
-      auto prediction = row.at(*it);
-      stack.insert(stack.end(), prediction.rbegin(), prediction.rend());
-      output_buffer.emplace_back(
-          seq_to_string(stack), seq_to_string(it, symbol_stream.end()),
-          to_string({top, prediction})
-      );
-    }
+  void mismatched(Symbol top, Symbol symbol) {
+    output_buffer.emplace_back(
+        "", "",
+        std::format(
+            "\033[31mError: {} not match {}\033[0m", symbols.to_string(top),
+            symbols.to_string(symbol)
+        )
+    );
   }
 
-  if (!has_error) {
+  void skipped(Symbol top, Symbol symbol) {
+    mismatched(top, symbol);
+  }
+
+  void synchronized(const auto &stack, auto it, Symbol top) {
+    output_buffer.emplace_back(
+        seq_to_string(stack, symbols), seq_to_string(it, input.end(), symbols),
+        std::format(
+            "\033[31mError: {} not match {}, popped\033[0m",
+            symbols.to_string(top), symbols.to_string(*it)
+        )
+    );
+  }
+
+  void exhausted(Symbol top) {
+    mismatched(top, Symbol::empty_symbol());
+  }
+};
+
+inline usize token_count(std::span<const Symbol> input) {
+  return input.empty() ? 0 : input.size() - 1;
+}
+
+inline usize token_count(const LexedInput &input) {
+  return input.token_count();
+}
+
+// `ll1_parse`, logging the errors into `errors` and counting the steps
+// into `counters` if not null. The tokens counted are those read, all of
+// them for a symbol stream.
+template<class Table, class Input, class Observer>
+bool counted_parse(
+    const Table &table, Symbol start_symbol, Input &input,
+    std::vector<Symbol> &stack, Observer &&observer, ErrorLog *errors,
+    ParseCounters *counters
+) {
+  ErrorLog local_errors;
+  auto &log = errors ? *errors : local_errors;
+  if (!counters)
+    return ll1_parse(table, start_symbol, input, stack, observer, log);
+  bool accepted = ll1_parse(
+      table, start_symbol, input, stack,
+      CountingObserver<std::remove_reference_t<Observer>>{observer, *counters},
+      log
+  );
+  counters->tokens += token_count(input);
+  counters->recoveries += log.errors.size();
+  return accepted;
+}
+
+bool CompiledGrammar::recognize(
+    std::span<const Symbol> symbol_stream, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  return visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, symbol_stream,
+        (scratch ? *scratch : local_scratch).stack, Recognizer{}, errors,
+        counters
+    );
+  });
+}
+
+bool CompiledGrammar::recognize(
+    LexedInput &input, ErrorLog *errors, ParseCounters *counters,
+    ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  return visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, input,
+        (scratch ? *scratch : local_scratch).stack, Recognizer{}, errors,
+        counters
+    );
+  });
+}
+
+Derivation CompiledGrammar::derive(
+    std::span<const Symbol> symbol_stream, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  Derivation derivation{};
+  derive(symbol_stream, derivation, errors, counters, scratch);
+  return derivation;
+}
+
+void CompiledGrammar::derive(
+    std::span<const Symbol> symbol_stream, Derivation &derivation,
+    ErrorLog *errors, ParseCounters *counters, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  derivation.steps.clear();
+  derivation.accepted = visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, symbol_stream,
+        (scratch ? *scratch : local_scratch).stack,
+        DerivationRecorder{derivation.steps}, errors, counters
+    );
+  });
+}
+
+void CompiledGrammar::derive(
+    LexedInput &input, Derivation &derivation, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  derivation.steps.clear();
+  derivation.accepted = visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, input,
+        (scratch ? *scratch : local_scratch).stack,
+        DerivationRecorder{derivation.steps}, errors, counters
+    );
+  });
+}
+
+bool CompiledGrammar::build_parse_tree(
+    std::span<const Symbol> symbol_stream, Tree &parse_tree, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  auto &buffers = scratch ? *scratch : local_scratch;
+  return visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, symbol_stream, buffers.stack,
+        ParseTreeBuilder{parse_tree, buffers.tree}, errors, counters
+    );
+  });
+}
+
+bool CompiledGrammar::build_parse_tree(
+    LexedInput &input, Tree &parse_tree, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  auto &buffers = scratch ? *scratch : local_scratch;
+  return visit_table([&](const auto &table) {
+    return counted_parse(
+        table, start_symbol_, input, buffers.stack,
+        ParseTreeBuilder{parse_tree, buffers.tree}, errors, counters
+    );
+  });
+}
+
+void CompiledGrammar::build_ast(
+    const Tree &parse_tree, Tree &ast, ParseScratch *scratch
+) const {
+  ParseScratch local_scratch;
+  ep::build_ast(
+      parse_tree, symbols(), ast,
+      (scratch ? *scratch : local_scratch).tree
+  );
+}
+
+bool CompiledGrammar::trace(
+    std::span<const Symbol> symbol_stream,
+    std::vector<OutputEntry> &output_buffer, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  return visit_table([&](const auto &table) {
+    return trace(
+        table, symbol_stream, output_buffer, errors, counters, scratch
+    );
+  });
+}
+
+bool CompiledGrammar::trace(
+    const Derivation &derivation, std::span<const Symbol> symbol_stream,
+    std::vector<OutputEntry> &output_buffer, ErrorLog *errors
+) const {
+  return visit_table([&](const auto &table) {
+    return trace(
+        DerivationReplay{table, derivation.steps}, symbol_stream,
+        output_buffer, errors, nullptr, nullptr
+    );
+  });
+}
+
+template<class Table>
+bool CompiledGrammar::trace(
+    const Table &table, std::span<const Symbol> symbol_stream,
+    std::vector<OutputEntry> &output_buffer, ErrorLog *errors,
+    ParseCounters *counters, ParseScratch *scratch
+) const {
+  output_buffer.emplace_back("<Stack>", "<Input>", "<Action>");
+
+  ParseScratch local_scratch;
+  bool accepted = counted_parse(
+      table, start_symbol_, symbol_stream,
+      (scratch ? *scratch : local_scratch).stack,
+      TraceRecorder{symbols(), symbol_stream, output_buffer}, errors,
+      counters
+  );
+
+  if (accepted) {
     output_buffer.pop_back();
     std::get<2>(output_buffer.back()) = "\033[32mAccept\033[0m";
   }
-
-  std::cout << std::format(
-                   "\033[32m-- Parsing procedure --\033[0m\n{}\n",
-                   parse_procedure_to_string(std::move(output_buffer))
-               )
-            << std::endl;
+  return accepted;
 }
 
-std::string
-Parser::parse_procedure_to_string(std::vector<OutputEntry> &&output_buffer) {
+std::string CompiledGrammar::parse_procedure_to_string(
+    std::vector<OutputEntry> &&output_buffer
+) {
   std::tuple<usize, usize, usize> max_len{0, 0, 0};
   for (const auto &[stack, input, action] : output_buffer) {
     max_len = std::make_tuple(
@@ -270,4 +495,249 @@ Parser::parse_procedure_to_string(std::vector<OutputEntry> &&output_buffer) {
   return buf;
 }
 
+LexedInput::LexedInput(
+    const CompiledGrammar &grammar, std::string_view src,
+    std::vector<Token> &tokens, std::vector<Symbol> &symbols
+):
+    grammar_(grammar), lexer_(src), tokens_(tokens), symbols_(symbols) {
+  tokens_.clear();
+  symbols_.clear();
+}
+
+void LexedInput::pull() {
+  for (std::optional<Token> token; (token = lexer_.next_token());) {
+    if (std::holds_alternative<Whitespace>(*token))
+      continue;
+    if (const auto *error = std::get_if<LexError>(&*token))
+      throw std::runtime_error(
+          std::format("Lex error at {}", error->span.offset)
+      );
+    symbols_.push_back(grammar_.lexeme_terminator(*token));
+    tokens_.push_back(*token);
+    return;
+  }
+  symbols_.push_back(Symbol::end_symbol());
+  complete_ = true;
+}
+
+LexedInput::iterator LexedInput::begin() {
+  return {*this, 0};
+}
+
+std::default_sentinel_t LexedInput::end() const {
+  return std::default_sentinel;
+}
+
+std::span<const Symbol> LexedInput::pull_all() {
+  while (!complete_)
+    pull();
+  return symbols_;
+}
+
+usize LexedInput::token_count() const {
+  return tokens_.size();
+}
+
+ParseSession::ParseSession(const CompiledGrammar &grammar):
+    grammar_(grammar), evaluator_(grammar.ops()) {}
+
+void ParseSession::set_mode(ParseMode mode) {
+  mode_ = mode;
+}
+
+const Derivation &ParseSession::derivation() const {
+  return derivation_;
+}
+
+const std::vector<Token> &ParseSession::token_stream() const {
+  return tokens_;
+}
+
+void ParseSession::set_metrics(Metrics *metrics) {
+  metrics_ = metrics;
+}
+
+void ParseSession::set_error_limit(usize limit) {
+  errors_.limit = limit;
+}
+
+const std::vector<ParseError> &ParseSession::errors() const {
+  return errors_.errors;
+}
+
+bool ParseSession::run(std::string_view src, std::string &out) {
+  std::chrono::steady_clock::time_point start{};
+  if (metrics_) {
+    counters_ = {};
+    start = std::chrono::steady_clock::now();
+  }
+
+  LexedInput input(grammar_, src, tokens_, symbols_);
+  bool accepted = parse_expression(input, src, out);
+  if (metrics_) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start
+    );
+    metrics_->record_parse(
+        counters_, accepted, static_cast<u64>(elapsed.count())
+    );
+  }
+  return accepted;
+}
+
+bool ParseSession::parse_expression(
+    LexedInput &input, std::string_view src, std::string &out
+) {
+  auto *errors = &errors_;
+  auto *counters = metrics_ ? &counters_ : nullptr;
+  auto *scratch = &scratch_;
+  switch (mode_) {
+    case ParseMode::Recognize: {
+      bool accepted = grammar_.recognize(input, errors, counters, scratch);
+      out.append(
+          accepted ? "\033[32mAccept\033[0m\n" : "\033[31mReject\033[0m\n"
+      );
+      return accepted;
+    }
+    case ParseMode::Derivation: {
+      auto &derivation = derivation_;
+      grammar_.derive(input, derivation, errors, counters, scratch);
+      for (auto step : derivation.steps) {
+        if (step == PredictionTable::no_entry)
+          out.append(1, '-');
+        else if (step == Derivation::resynchronized)
+          out.append(1, '^');
+        else
+          std::format_to(std::back_inserter(out), "{}", step);
+        out.append(1, ' ');
+      }
+      out.append(
+          derivation.accepted ? "\033[32mAccept\033[0m\n"
+                              : "\033[31mReject\033[0m\n"
+      );
+      return derivation.accepted;
+    }
+    case ParseMode::Ast: {
+      bool accepted = grammar_.build_parse_tree(
+          input, parse_tree_, errors, counters, scratch
+      );
+      if (!accepted) {
+        out.append("\033[31mReject\033[0m\n");
+        return false;
+      }
+      grammar_.build_ast(parse_tree_, ast_, scratch);
+      append_string(ast_, grammar_.symbols(), out, scratch_.tree);
+      out.append(1, '\n');
+      return true;
+    }
+    case ParseMode::Evaluate: {
+      bool accepted = grammar_.build_parse_tree(
+          input, parse_tree_, errors, counters, scratch
+      );
+      if (!accepted) {
+        out.append("\033[31mReject\033[0m\n");
+        return false;
+      }
+      grammar_.build_ast(parse_tree_, ast_, scratch);
+      std::visit(
+          overloaded{
+              [&](i64 value) {
+                std::format_to(std::back_inserter(out), "{}\n", value);
+              },
+              [&](const EvalError &error) {
+                out.append("\033[31mError: ");
+                append_string(error, out);
+                out.append("\033[0m\n");
+              },
+          },
+          evaluator_.evaluate(ast_, tokens_)
+      );
+      return true;
+    }
+    case ParseMode::Compile: {
+      bool accepted = grammar_.build_parse_tree(
+          input, parse_tree_, errors, counters, scratch
+      );
+      if (!accepted) {
+        out.append("\033[31mReject\033[0m\n");
+        return false;
+      }
+      grammar_.build_ast(parse_tree_, ast_, scratch);
+      std::visit(
+          overloaded{
+              [&](const Program &program) {
+                out.append(to_string(program)).append("\n\n");
+              },
+              [&](const EvalError &error) {
+                out.append("\033[31mError: ");
+                append_string(error, out);
+                out.append("\033[0m\n");
+              },
+          },
+          compile(ast_, tokens_, src, grammar_.ops())
+      );
+      return true;
+    }
+    case ParseMode::Trace:
+      break;
+  }
+
+  // The trace shows the rest of the input at every step, so it needs all
+  // of it from the start.
+  auto symbol_stream = input.pull_all();
+  std::vector<CompiledGrammar::OutputEntry> output_buffer;
+  bool accepted =
+      grammar_.trace(symbol_stream, output_buffer, errors, counters, scratch);
+  out.append(std::format(
+      "\033[32m-- Parsing procedure --\033[0m\n{}\n\n",
+      grammar_.parse_procedure_to_string(std::move(output_buffer))
+  ));
+  return accepted;
+}
+
+Parser::Parser(std::shared_ptr<const CompiledGrammar> grammar):
+    grammar_(std::move(grammar)), session_(*grammar_) {}
+
+Parser::Parser(Grammar grammar, Metrics *metrics):
+    Parser(std::make_shared<const CompiledGrammar>(std::move(grammar), metrics)
+    ) {}
+
+Parser::Parser(TableFile table_file):
+    Parser(std::make_shared<const CompiledGrammar>(std::move(table_file))) {}
+
+const CompiledGrammar &Parser::grammar() const {
+  return *grammar_;
+}
+
+std::shared_ptr<const CompiledGrammar> Parser::shared_grammar() const {
+  return grammar_;
+}
+
+void Parser::set_mode(ParseMode mode) {
+  session_.set_mode(mode);
+}
+
+void Parser::set_metrics(Metrics *metrics) {
+  session_.set_metrics(metrics);
+}
+
+void Parser::set_error_limit(usize limit) {
+  session_.set_error_limit(limit);
+}
+
+bool Parser::load_source(std::string_view src) {
+  out_.clear();
+  bool accepted = session_.run(src, out_);
+  std::cout << out_ << std::flush;
+  return accepted;
+}
+
+const Derivation &Parser::derivation() const {
+  return session_.derivation();
+}
+
+const std::vector<Token> &Parser::token_stream() const {
+  return session_.token_stream();
+}
+
 } // namespace ep
@@ -3,33 +3,370 @@
 #ifndef EP_PARSER_PARSER_H
 #  define EP_PARSER_PARSER_H
 
+#  include "eval/bytecode.h"
+#  include "eval/evaluator.h"
+#  include "parser/driver.h"
 #  include "parser/grammar.h"
+#  include "parser/metrics.h"
+#  include "parser/parse_tree.h"
+#  include "parser/static_grammar.h"
+#  include "parser/table_file.h"
 #  include "simple_lexer/lexer.h"
 #  include "util/all.h"
 
+#  include <array>
+#  include <iterator>
+#  include <memory>
+#  include <mutex>
+#  include <optional>
+#  include <span>
+#  include <string>
+#  include <string_view>
+#  include <tuple>
+#  include <vector>
+
 namespace ep {
 
-class Parser {
-  Lexer lexer_{};
+enum class ParseMode {
+  Trace,      // Print every step of the parse.
+  Derivation, // Record the production indices of a leftmost derivation.
+  Recognize,  // Only accept or reject.
+  Ast,        // Build the parse tree and fold it into an AST.
+  Evaluate,   // Build the AST and evaluate it.
+  Compile,    // Build the AST and lower it to bytecode.
+};
+
+// Scratch space of the parses of a `CompiledGrammar`. Handed to each of a
+// series of parses, it is reused, so that once it has grown to the largest
+// input the parses allocate nothing.
+struct ParseScratch {
+  std::vector<Symbol> stack{};
+  TreeScratch tree{};
+};
+
+class LexedInput;
+
+// Everything a parse needs from the grammar: the symbols, the prediction
+// table and the terminators of the lexemes. Built once and never modified,
+// so any number of threads may parse against one `CompiledGrammar` at the
+// same time, each with its own `ParseSession`.
+//
+// Loaded from a table file, it keeps the mapping and parses against it in
+// place; nothing is copied out of it until `symbols()` is first called.
+class CompiledGrammar {
   Grammar grammar_{};
   PredictionTable prediction_table_{};
+  std::optional<TableFile> table_file_{};
+  // The symbols of `table_file_`, copied out on first use.
+  mutable SymbolTable file_symbols_{};
+  mutable std::once_flag file_symbols_copied_{};
+  Symbol start_symbol_{};
+  std::optional<Symbol> integer_symbol_{};
+  std::optional<Symbol> identifier_symbol_{};
+  std::array<std::optional<Symbol>, 256> punctuator_symbols_{};
+  ArithOpTable ops_{};
 
+public:
   using OutputEntry = std::tuple<std::string, std::string, std::string>;
 
+private:
+  // `symbols` is a `SymbolTable` or a `TableFile`.
+  template<class Symbols>
+  void resolve_lexeme_symbols(const Symbols &symbols);
+
+  template<class Table>
+  bool trace(
+      const Table &table, std::span<const Symbol> symbol_stream,
+      std::vector<OutputEntry> &output_buffer, ErrorLog *errors,
+      ParseCounters *counters, ParseScratch *scratch
+  ) const;
+
 public:
-  explicit Parser(Grammar grammar);
+  // Transforms and analyzes `grammar`, printing every stage. The time of
+  // each is recorded into `metrics` if given.
+  explicit CompiledGrammar(Grammar grammar, Metrics *metrics = nullptr);
+
+  // Skips the whole analysis, the table having been built elsewhere.
+  CompiledGrammar(
+      SymbolTable symbols, PredictionTable prediction_table, Symbol start_symbol
+  );
+
+  template<usize T, usize N, usize P, usize R, usize C>
+  explicit CompiledGrammar(const StaticGrammar<T, N, P, R, C> &grammar):
+      CompiledGrammar(
+          grammar.symbol_table(), grammar.prediction_table(),
+          grammar.start_symbol
+      ) {}
+
+  // Starts from a table saved by `write_table_file`, parsing against the
+  // mapping itself.
+  explicit CompiledGrammar(TableFile table_file);
+
+  // Calls `f` with the table that parses run against, and returns what it
+  // returns: the mapped `TableFile` if the grammar was loaded from one, else
+  // `prediction_table()`.
+  template<class F>
+  decltype(auto) visit_table(F &&f) const {
+    if (table_file_)
+      return f(*table_file_);
+    return f(prediction_table_);
+  }
+
+  [[nodiscard]] std::vector<Symbol>
+  convert_lexeme_to_symbol(const std::vector<Token> &token_stream) const;
+
+  // Replaces the contents of `symbol_stream`, keeping its capacity.
+  void convert_lexeme_to_symbol(
+      const std::vector<Token> &token_stream,
+      std::vector<Symbol> &symbol_stream
+  ) const;
+
+  // The terminator of a single token, if the grammar has one for it.
+  [[nodiscard]] std::optional<Symbol> lexeme_symbol(const Token &token) const;
+
+  // The terminator of an integer, identifier or punctuator. Throws
+  // `std::runtime_error` if the grammar has none for it.
+  [[nodiscard]] Symbol lexeme_terminator(const Token &token) const;
+
+  // For a grammar loaded from a table file, a copy of its symbols made on
+  // the first call, which only rendering and building ASTs need.
+  [[nodiscard]] const SymbolTable &symbols() const;
 
-  void load_source(std::string src);
+  // Empty for a grammar loaded from a table file; see `visit_table`.
+  [[nodiscard]] const PredictionTable &prediction_table() const;
 
-  [[nodiscard]] static std::vector<Symbol>
-  convert_lexeme_to_symbol(const std::vector<Token> &token_stream);
+  [[nodiscard]] Symbol start_symbol() const;
 
-  void parse_expression(std::vector<Symbol> &&symbol_stream);
+  [[nodiscard]] const ArithOpTable &ops() const;
+
+  // The following take a symbol stream terminated by `Symbol::end_symbol()`
+  // and all give the same verdict. Given `errors`, they log the errors
+  // there, up to its limit; given `counters`, they add the steps of the
+  // parse to them; given `scratch`, they use its buffers instead of their
+  // own. `recognize` and `build_parse_tree` stop at the first error. Given
+  // a `LexedInput` instead, they lex it only as far as the parse reads.
+
+  [[nodiscard]] bool recognize(
+      std::span<const Symbol> symbol_stream, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  [[nodiscard]] bool recognize(
+      LexedInput &input, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  [[nodiscard]] Derivation derive(
+      std::span<const Symbol> symbol_stream, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  // Records into `derivation`, whose steps keep their capacity.
+  void derive(
+      std::span<const Symbol> symbol_stream, Derivation &derivation,
+      ErrorLog *errors = nullptr, ParseCounters *counters = nullptr,
+      ParseScratch *scratch = nullptr
+  ) const;
+
+  void derive(
+      LexedInput &input, Derivation &derivation, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  bool trace(
+      std::span<const Symbol> symbol_stream,
+      std::vector<OutputEntry> &output_buffer, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  bool build_parse_tree(
+      std::span<const Symbol> symbol_stream, Tree &parse_tree,
+      ErrorLog *errors = nullptr, ParseCounters *counters = nullptr,
+      ParseScratch *scratch = nullptr
+  ) const;
+
+  bool build_parse_tree(
+      LexedInput &input, Tree &parse_tree, ErrorLog *errors = nullptr,
+      ParseCounters *counters = nullptr, ParseScratch *scratch = nullptr
+  ) const;
+
+  void build_ast(
+      const Tree &parse_tree, Tree &ast, ParseScratch *scratch = nullptr
+  ) const;
+
+  // Renders a derivation recorded by `derive` over the same symbol stream,
+  // with an error log of the same limit.
+  bool trace(
+      const Derivation &derivation, std::span<const Symbol> symbol_stream,
+      std::vector<OutputEntry> &output_buffer, ErrorLog *errors = nullptr
+  ) const;
 
   static std::string
   parse_procedure_to_string(std::vector<OutputEntry> &&output_buffer);
 };
 
+// The terminators of a source, lexed as a parse reads them rather than all
+// up front, so that a parse stopping at an error leaves the rest of the
+// source unscanned. Each token is mapped to its terminator as soon as it is
+// lexed, and both are appended to the buffers given, which are cleared
+// first; the terminators end with `Symbol::end_symbol()` once the source is
+// exhausted. A lex error, or a token the grammar has no terminator for,
+// throws `std::runtime_error` when the parse reaches it.
+class LexedInput {
+  const CompiledGrammar &grammar_;
+  Lexer lexer_;
+  std::vector<Token> &tokens_;
+  std::vector<Symbol> &symbols_;
+  bool complete_{};
+
+  // Appends the terminator of the next token, or the end symbol.
+  void pull();
+
+public:
+  // Reads the terminators in order, lexing each one the first time it is
+  // read; the end is found by lexing up to it.
+  class iterator {
+    LexedInput *input_{};
+    usize pos_{};
+
+  public:
+    iterator() = default;
+
+    iterator(LexedInput &input, usize pos): input_(&input), pos_(pos) {}
+
+    [[nodiscard]] Symbol operator*() const {
+      if (pos_ == input_->symbols_.size())
+        input_->pull();
+      return input_->symbols_[pos_];
+    }
+
+    iterator &operator++() {
+      ++pos_;
+      return *this;
+    }
+
+    [[nodiscard]] bool operator==(std::default_sentinel_t) const {
+      if (pos_ == input_->symbols_.size() && !input_->complete_)
+        input_->pull();
+      return pos_ == input_->symbols_.size();
+    }
+
+    [[nodiscard]] friend isize
+    operator-(const iterator &lhs, const iterator &rhs) {
+      return static_cast<isize>(lhs.pos_) - static_cast<isize>(rhs.pos_);
+    }
+  };
+
+  // `src` must outlive the input.
+  LexedInput(
+      const CompiledGrammar &grammar, std::string_view src,
+      std::vector<Token> &tokens, std::vector<Symbol> &symbols
+  );
+
+  LexedInput(const LexedInput &rhs) = delete;
+
+  LexedInput &operator=(const LexedInput &rhs) = delete;
+
+  [[nodiscard]] iterator begin();
+
+  [[nodiscard]] std::default_sentinel_t end() const;
+
+  // Lexes the rest of the source; all of its terminators.
+  std::span<const Symbol> pull_all();
+
+  // The tokens lexed so far, whitespace excluded.
+  [[nodiscard]] usize token_count() const;
+};
+
+// The mutable side of parsing: the mode and the buffers of a single parse,
+// reused from one input to the next, which only ever grow. Once they fit
+// the largest input, a parse allocates nothing in the modes that do not
+// render it, i.e. all but `Trace` and `Compile`, as long as `out` has room.
+// Belongs to one thread at a time.
+class ParseSession {
+  const CompiledGrammar &grammar_;
+  ParseMode mode_{ParseMode::Trace};
+  std::vector<Token> tokens_{};
+  std::vector<Symbol> symbols_{};
+  ParseScratch scratch_{};
+  Derivation derivation_{};
+  Tree parse_tree_{};
+  Tree ast_{};
+  Evaluator evaluator_{};
+  ErrorLog errors_{};
+  Metrics *metrics_{};
+  ParseCounters counters_{};
+
+  bool
+  parse_expression(LexedInput &input, std::string_view src, std::string &out);
+
+public:
+  // `grammar` must outlive the session.
+  explicit ParseSession(const CompiledGrammar &grammar);
+
+  void set_mode(ParseMode mode);
+
+  // Records the counters and latency of every parse into `metrics` from now
+  // on, or stops recording if null.
+  void set_metrics(Metrics *metrics);
+
+  // Errors tolerated per input before the parse gives up; see `ErrorLog`.
+  void set_error_limit(usize limit);
+
+  // Lexes and parses `src` in place; it is not copied, and the spans of
+  // `token_stream()` refer to it. Lexing goes no further than the parse
+  // reads, so after a rejection `token_stream()` may end at the error.
+  // Appends the result of the current mode to `out`.
+  bool run(std::string_view src, std::string &out);
+
+  // The derivation recorded by the last parse in `ParseMode::Derivation`.
+  [[nodiscard]] const Derivation &derivation() const;
+
+  // The tokens of the last source parsed, whitespace excluded.
+  [[nodiscard]] const std::vector<Token> &token_stream() const;
+
+  // The errors of the last parse, positions being indices into the symbol
+  // stream of `token_stream()`.
+  [[nodiscard]] const std::vector<ParseError> &errors() const;
+};
+
+// A compiled grammar together with a session of its own, for parsing on a
+// single thread. Other threads can share `grammar()` with sessions of their
+// own.
+class Parser {
+  std::shared_ptr<const CompiledGrammar> grammar_;
+  ParseSession session_;
+  std::string out_{};
+
+public:
+  explicit Parser(std::shared_ptr<const CompiledGrammar> grammar);
+
+  explicit Parser(Grammar grammar, Metrics *metrics = nullptr);
+
+  template<usize T, usize N, usize P, usize R, usize C>
+  explicit Parser(const StaticGrammar<T, N, P, R, C> &grammar):
+      Parser(std::make_shared<const CompiledGrammar>(grammar)) {}
+
+  explicit Parser(TableFile table_file);
+
+  [[nodiscard]] const CompiledGrammar &grammar() const;
+
+  [[nodiscard]] std::shared_ptr<const CompiledGrammar> shared_grammar() const;
+
+  void set_mode(ParseMode mode);
+
+  void set_metrics(Metrics *metrics);
+
+  void set_error_limit(usize limit);
+
+  // Parses `src` like `ParseSession::run` and prints the result.
+  bool load_source(std::string_view src);
+
+  [[nodiscard]] const Derivation &derivation() const;
+
+  [[nodiscard]] const std::vector<Token> &token_stream() const;
+};
+
 } // namespace ep
 
 #endif // EP_PARSER_PARSER_H
@@ -0,0 +1,606 @@
+#pragma once
+
+#ifndef EP_PARSER_STATIC_GRAMMAR_H
+#  define EP_PARSER_STATIC_GRAMMAR_H
+
+#  include "parser/grammar.h"
+#  include "util/type.h"
+
+#  include <algorithm>
+#  include <array>
+#  include <optional>
+#  include <span>
+#  include <stdexcept>
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace ep {
+
+namespace detail {
+
+// Not constexpr on purpose: reaching one of these while evaluating
+// `static_grammar` makes the evaluation non-constant, i.e. a compile error
+// naming the problem.
+inline void static_grammar_is_malformed() {
+  throw std::invalid_argument("Grammar is malformed");
+}
+
+inline void static_grammar_is_not_ll1() {
+  throw std::logic_error("Grammar is not LL(1)");
+}
+
+constexpr std::vector<std::string_view>
+static_split(std::string_view str, std::string_view sep) {
+  std::vector<std::string_view> result{};
+  std::string_view::size_type pos = 0;
+  while (pos < str.size()) {
+    auto next_pos = str.find(sep, pos);
+    if (next_pos == std::string_view::npos) {
+      result.push_back(str.substr(pos));
+      break;
+    }
+    result.push_back(str.substr(pos, next_pos - pos));
+    pos = next_pos + sep.size();
+  }
+  return result;
+}
+
+constexpr std::string static_to_string(u32 value) {
+  std::string buf{};
+  do
+    buf.insert(buf.begin(), static_cast<char>('0' + value % 10));
+  while (value /= 10);
+  return buf;
+}
+
+struct StaticProduction {
+  Symbol lhs{};
+  std::vector<Symbol> rhs{};
+
+  constexpr bool operator<(const StaticProduction &rhs_) const {
+    if (lhs != rhs_.lhs)
+      return lhs < rhs_.lhs;
+    return std::lexicographical_compare(
+        rhs.begin(), rhs.end(), rhs_.rhs.begin(), rhs_.rhs.end()
+    );
+  }
+
+  constexpr bool operator==(const StaticProduction &rhs_) const = default;
+};
+
+// The shape of a compiled grammar, i.e. the template arguments of the
+// `StaticGrammar` holding it.
+struct StaticGrammarShape {
+  usize terminator_count{};
+  usize nonterminator_count{};
+  usize production_count{};
+  usize rhs_pool_size{};
+  usize name_pool_size{};
+};
+
+// Constant-evaluated counterpart of `Grammar`. The passes below mirror
+// their runtime namesakes step for step (same interning order, same
+// production order), so that both paths produce identical tables.
+struct StaticGrammarBuilder {
+  std::vector<std::string> terminator_names{"", "$"};
+  std::vector<std::string> nonterminator_names{};
+  std::vector<SymbolOrigin> nonterminator_origins{};
+  std::vector<StaticProduction> productions{};
+
+  std::vector<std::vector<u8>> first_set{};
+  std::vector<std::vector<u8>> follow_set{};
+
+  std::vector<u32> cells{};
+  std::vector<u8> follow{};
+  std::vector<Production> table_productions{};
+  std::vector<Symbol> rhs_pool{};
+
+  constexpr Symbol intern(
+      std::string_view name, Symbol::Type type,
+      SymbolOrigin origin = SymbolOrigin::Source
+  ) {
+    for (u32 i = 0; i < terminator_names.size(); ++i)
+      if (terminator_names[i] == name)
+        return {i, Symbol::Terminator};
+    for (u32 i = 0; i < nonterminator_names.size(); ++i)
+      if (nonterminator_names[i] == name)
+        return {i, Symbol::NonTerminator};
+
+    if (type == Symbol::NonTerminator)
+      nonterminator_origins.push_back(origin);
+    auto &names =
+        type == Symbol::Terminator ? terminator_names : nonterminator_names;
+    names.emplace_back(name);
+    return {static_cast<u32>(names.size() - 1), type};
+  }
+
+  [[nodiscard]] constexpr const std::string &name(Symbol symbol) const {
+    if (symbol.type == Symbol::Terminator)
+      return terminator_names[symbol.id];
+    return nonterminator_names[symbol.id];
+  }
+
+  constexpr void normalize() {
+    std::sort(productions.begin(), productions.end());
+    productions.erase(
+        std::unique(productions.begin(), productions.end()), productions.end()
+    );
+  }
+
+  // Returns one past the last production sharing the lhs of productions[i].
+  [[nodiscard]] constexpr usize group_end(usize i) const {
+    usize j = i;
+    while (j < productions.size() && productions[j].lhs == productions[i].lhs)
+      ++j;
+    return j;
+  }
+
+  constexpr void from_str(std::string_view str) {
+    for (auto line : static_split(str, "\n")) {
+      auto vec = static_split(line, " -> ");
+      if (vec.size() != 2)
+        static_grammar_is_malformed();
+      auto lhs = intern(vec[0], Symbol::NonTerminator);
+      for (auto rhs : static_split(vec[1], " | ")) {
+        std::vector<Symbol> rhs_symbol_vec{};
+        for (auto symbol : static_split(rhs, " ")) {
+          if (symbol == "ε")
+            rhs_symbol_vec.emplace_back(Symbol::empty_symbol());
+          else if (!symbol.empty() && 'A' <= symbol[0] && symbol[0] <= 'Z')
+            rhs_symbol_vec.emplace_back(intern(symbol, Symbol::NonTerminator));
+          else
+            rhs_symbol_vec.emplace_back(intern(symbol, Symbol::Terminator));
+        }
+        if (rhs_symbol_vec.empty())
+          static_grammar_is_malformed();
+        productions.push_back({lhs, std::move(rhs_symbol_vec)});
+      }
+    }
+    normalize();
+  }
+
+  using Alternatives = std::vector<std::vector<Symbol>>;
+
+  // The sorted alternatives of every nonterminator, by id.
+  [[nodiscard]] constexpr std::vector<Alternatives> alternatives() const {
+    std::vector<Alternatives> result(nonterminator_names.size());
+    for (const auto &[lhs, rhs] : productions)
+      result[lhs.id].push_back(rhs);
+    return result;
+  }
+
+  constexpr void assign(std::vector<Alternatives> &&alternatives) {
+    productions.clear();
+    for (u32 i = 0; i < alternatives.size(); ++i)
+      for (auto &rhs : alternatives[i])
+        productions.push_back({{i, Symbol::NonTerminator}, std::move(rhs)});
+    normalize();
+  }
+
+  [[nodiscard]] constexpr bool is_interned(std::string_view name) const {
+    return std::find(terminator_names.begin(), terminator_names.end(), name) !=
+               terminator_names.end() ||
+           std::find(
+               nonterminator_names.begin(), nonterminator_names.end(), name
+           ) != nonterminator_names.end();
+  }
+
+  static constexpr std::vector<Symbol> concatenate(
+      const std::vector<Symbol> &lhs, const std::vector<Symbol> &rhs,
+      usize rhs_from
+  ) {
+    std::vector<Symbol> result{};
+    for (auto symbol : lhs)
+      if (symbol != Symbol::empty_symbol())
+        result.push_back(symbol);
+    for (usize i = rhs_from; i < rhs.size(); ++i)
+      if (rhs[i] != Symbol::empty_symbol())
+        result.push_back(rhs[i]);
+    if (result.empty())
+      result.push_back(Symbol::empty_symbol());
+    return result;
+  }
+
+  // Nonterminators on the same left recursive cycle are those reaching each
+  // other, which the runtime pass finds as strongly connected components.
+  constexpr void eliminate_left_recursion() {
+    auto rules = alternatives();
+    const usize count = rules.size();
+
+    std::vector<std::vector<u8>> reaches(count, std::vector<u8>(count, 0));
+    for (usize a = 0; a < count; ++a)
+      for (const auto &rhs : rules[a])
+        if (rhs.front().type == Symbol::NonTerminator)
+          reaches[a][rhs.front().id] = 1;
+    for (usize k = 0; k < count; ++k)
+      for (usize a = 0; a < count; ++a)
+        if (reaches[a][k])
+          for (usize b = 0; b < count; ++b)
+            reaches[a][b] |= reaches[k][b];
+    auto on_cycle = [&](Symbol lhs, Symbol symbol) {
+      return symbol.type == Symbol::NonTerminator && symbol.id <= lhs.id &&
+             reaches[lhs.id][symbol.id] && reaches[symbol.id][lhs.id];
+    };
+
+    for (u32 i = 0; i < count; ++i) {
+      Symbol lhs{i, Symbol::NonTerminator};
+      bool affected = false;
+      for (const auto &rhs : rules[i])
+        affected |= on_cycle(lhs, rhs.front());
+      if (!affected)
+        continue;
+
+      auto pending = std::move(rules[i]);
+      Alternatives kept{}, tails{};
+      while (!pending.empty()) {
+        auto rhs = std::move(pending.back());
+        pending.pop_back();
+        auto front = rhs.front();
+        if (front == lhs) {
+          if (rhs.size() > 1)
+            tails.emplace_back(rhs.begin() + 1, rhs.end());
+        } else if (on_cycle(lhs, front)) {
+          for (const auto &alternative : rules[front.id])
+            pending.push_back(concatenate(alternative, rhs, 1));
+        } else {
+          kept.push_back(std::move(rhs));
+        }
+      }
+      if (tails.empty()) {
+        rules[i] = std::move(kept);
+        continue;
+      }
+
+      auto new_name = name(lhs) + "'";
+      while (is_interned(new_name))
+        new_name += '\'';
+      auto new_lhs = intern(
+          new_name, Symbol::NonTerminator, SymbolOrigin::LeftRecursion
+      );
+      for (auto &rhs : kept) {
+        if (rhs.front() == Symbol::empty_symbol())
+          rhs.clear();
+        rhs.push_back(new_lhs);
+      }
+      for (auto &rhs : tails)
+        rhs.push_back(new_lhs);
+      tails.push_back({Symbol::empty_symbol()});
+      rules[i] = std::move(kept);
+      rules.push_back(std::move(tails));
+    }
+
+    assign(std::move(rules));
+  }
+
+  constexpr void extract_left_factoring() {
+    auto rules = alternatives();
+    std::vector<u32> worklist{};
+    for (u32 i = 0; i < rules.size(); ++i)
+      worklist.push_back(i);
+
+    for (usize next = 0; next < worklist.size(); ++next) {
+      auto lhs = Symbol{worklist[next], Symbol::NonTerminator};
+      auto current = std::move(rules[lhs.id]);
+
+      Alternatives factored{};
+      u32 counter = 0;
+      for (usize a = 0, b; a < current.size(); a = b) {
+        b = a + 1;
+        while (b < current.size() && current[b].front() == current[a].front())
+          ++b;
+        if (b - a == 1) {
+          factored.push_back(std::move(current[a]));
+          continue;
+        }
+
+        auto shared = std::mismatch(
+            current[a].begin(), current[a].end(), current[b - 1].begin(),
+            current[b - 1].end()
+        );
+        auto prefix = shared.first - current[a].begin();
+        std::string new_name{};
+        do
+          new_name = name(lhs) + static_to_string(++counter);
+        while (is_interned(new_name));
+        auto new_lhs = intern(
+            new_name, Symbol::NonTerminator, SymbolOrigin::LeftFactoring
+        );
+
+        std::vector<Symbol> head(
+            current[a].begin(), current[a].begin() + prefix
+        );
+        head.push_back(new_lhs);
+        factored.push_back(std::move(head));
+
+        // Still sorted, with ε in place of an empty rest.
+        Alternatives tails{};
+        for (usize k = a; k < b; ++k) {
+          tails.emplace_back(current[k].begin() + prefix, current[k].end());
+          if (tails.back().empty())
+            tails.back().push_back(Symbol::empty_symbol());
+        }
+        rules.push_back(std::move(tails));
+        worklist.push_back(new_lhs.id);
+      }
+      std::sort(factored.begin(), factored.end());
+      rules[lhs.id] = std::move(factored);
+    }
+
+    assign(std::move(rules));
+  }
+
+  // FIRST of a single symbol as a membership vector over terminator ids.
+  [[nodiscard]] constexpr std::vector<u8> first_of(Symbol symbol) const {
+    if (symbol.type == Symbol::NonTerminator)
+      return first_set[symbol.id];
+    std::vector<u8> result(terminator_names.size(), 0);
+    result[symbol.id] = 1;
+    return result;
+  }
+
+  // FIRST of `sequence[from..]`, with ε if all of it can derive ε.
+  [[nodiscard]] constexpr std::vector<u8>
+  first_of(const std::vector<Symbol> &sequence, usize from = 0) const {
+    std::vector<u8> result(terminator_names.size(), 0);
+    for (usize i = from; i < sequence.size(); ++i) {
+      if (sequence[i] == Symbol::empty_symbol())
+        continue;
+      auto first_set_symbol = first_of(sequence[i]);
+      merge_into(result, first_set_symbol, true);
+      if (!first_set_symbol[Symbol::empty_symbol().id])
+        return result;
+    }
+    result[Symbol::empty_symbol().id] = 1;
+    return result;
+  }
+
+  static constexpr bool merge_into(
+      std::vector<u8> &dst, const std::vector<u8> &src, bool skip_empty
+  ) {
+    bool changed = false;
+    for (usize i = skip_empty ? 1 : 0; i < src.size(); ++i)
+      if (src[i] && !dst[i])
+        dst[i] = 1, changed = true;
+    return changed;
+  }
+
+  constexpr void build_first_set() {
+    first_set.assign(
+        nonterminator_names.size(),
+        std::vector<u8>(terminator_names.size(), 0)
+    );
+
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (const auto &[lhs, rhs] : productions)
+        changed |= merge_into(first_set[lhs.id], first_of(rhs), false);
+    }
+  }
+
+  constexpr void build_follow_set(Symbol start_symbol) {
+    follow_set.assign(
+        nonterminator_names.size(),
+        std::vector<u8>(terminator_names.size(), 0)
+    );
+    follow_set[start_symbol.id][Symbol::end_symbol().id] = 1;
+
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (const auto &[lhs, rhs] : productions) {
+        for (usize i = 0; i < rhs.size(); ++i) {
+          if (rhs[i].type == Symbol::Terminator)
+            continue;
+
+          auto &follow_set_lhs = follow_set[rhs[i].id];
+          auto first_set_suffix = first_of(rhs, i + 1);
+          changed |= merge_into(follow_set_lhs, first_set_suffix, true);
+          if (first_set_suffix[Symbol::empty_symbol().id])
+            changed |= merge_into(follow_set_lhs, follow_set[lhs.id], false);
+        }
+      }
+    }
+  }
+
+  // No two alternatives of a nonterminator may claim the same cell, nor
+  // both derive ε, like `Grammar::find_conflicts`.
+  constexpr void check_ll1() const {
+    for (usize i = 0, j; i < productions.size(); i = j) {
+      j = group_end(i);
+      const auto &follow_set_lhs = follow_set[productions[i].lhs.id];
+
+      std::vector<u8> claimed(terminator_names.size(), 0);
+      for (usize k = i; k < j; ++k) {
+        auto cells = first_of(productions[k].rhs);
+        if (cells[Symbol::empty_symbol().id])
+          merge_into(cells, follow_set_lhs, false);
+        for (usize t = 0; t < cells.size(); ++t) {
+          if (cells[t] && claimed[t])
+            static_grammar_is_not_ll1();
+          claimed[t] |= cells[t];
+        }
+      }
+    }
+  }
+
+  constexpr void build_prediction_table() {
+    auto terminator_count = terminator_names.size();
+    cells.assign(
+        terminator_count * nonterminator_names.size(), PredictionTable::no_entry
+    );
+    follow.clear();
+    for (const auto &follow_set_lhs : follow_set)
+      follow.insert(follow.end(), follow_set_lhs.begin(), follow_set_lhs.end());
+
+    for (const auto &[lhs, rhs] : productions) {
+      auto production = static_cast<u32>(table_productions.size());
+      table_productions.push_back(
+          {lhs, static_cast<u32>(rhs_pool.size()), static_cast<u32>(rhs.size())}
+      );
+      rhs_pool.insert(rhs_pool.end(), rhs.begin(), rhs.end());
+
+      auto predict = [&](usize terminator) {
+        if (terminator != Symbol::empty_symbol().id)
+          cells[lhs.id * terminator_count + terminator] = production;
+      };
+
+      auto first_set_rhs = first_of(rhs);
+      for (usize t = 0; t < terminator_count; ++t)
+        if (first_set_rhs[t])
+          predict(t);
+      if (first_set_rhs[Symbol::empty_symbol().id])
+        for (usize t = 0; t < terminator_count; ++t)
+          if (follow_set[lhs.id][t])
+            predict(t);
+    }
+  }
+
+  [[nodiscard]] constexpr StaticGrammarShape shape() const {
+    usize name_pool_size = 0;
+    for (const auto &name : terminator_names)
+      name_pool_size += name.size();
+    for (const auto &name : nonterminator_names)
+      name_pool_size += name.size();
+    return {
+        terminator_names.size(), nonterminator_names.size(),
+        table_productions.size(), rhs_pool.size(), name_pool_size
+    };
+  }
+};
+
+// The start symbol is the lhs of the first line, which is always interned
+// first and hence nonterminator #0.
+constexpr StaticGrammarBuilder compile_static_grammar(std::string_view str) {
+  StaticGrammarBuilder builder{};
+  builder.from_str(str);
+  builder.eliminate_left_recursion();
+  builder.extract_left_factoring();
+  builder.build_first_set();
+  builder.build_follow_set({0, Symbol::NonTerminator});
+  builder.check_ll1();
+  builder.build_prediction_table();
+  return builder;
+}
+
+} // namespace detail
+
+// A grammar compiled entirely at compile time. Exposes the same lookup
+// interface as `PredictionTable`, backed by fixed-size arrays.
+template<usize T, usize N, usize P, usize R, usize C>
+struct StaticGrammar {
+  static constexpr usize terminator_count = T;
+  static constexpr usize nonterminator_count = N;
+
+  std::array<u32, T * N> cells{};
+  std::array<u8, T * N> follow{};
+  std::array<Production, P> productions{};
+  std::array<Symbol, R> rhs_pool{};
+  std::array<char, C> name_pool{};
+  std::array<u32, T + N + 1> name_offsets{};
+  std::array<SymbolOrigin, N> origins{};
+  Symbol start_symbol{0, Symbol::NonTerminator};
+
+  [[nodiscard]] constexpr u32
+  lookup(Symbol nonterminator, Symbol terminator) const {
+    return cells[nonterminator.id * T + terminator.id];
+  }
+
+  [[nodiscard]] constexpr bool
+  synchronizes(Symbol nonterminator, Symbol terminator) const {
+    return follow[nonterminator.id * T + terminator.id] != 0;
+  }
+
+  [[nodiscard]] constexpr std::span<const Symbol> rhs(u32 production) const {
+    const auto &[_, offset, length] = productions[production];
+    return {rhs_pool.data() + offset, length};
+  }
+
+  [[nodiscard]] constexpr std::string_view name(Symbol symbol) const {
+    auto index = symbol.type == Symbol::Terminator ? symbol.id : T + symbol.id;
+    return {
+        name_pool.data() + name_offsets[index],
+        name_offsets[index + 1] - name_offsets[index]
+    };
+  }
+
+  [[nodiscard]] constexpr std::optional<Symbol> find(std::string_view name_
+  ) const {
+    for (u32 i = 0; i < T; ++i)
+      if (name({i, Symbol::Terminator}) == name_)
+        return Symbol{i, Symbol::Terminator};
+    for (u32 i = 0; i < N; ++i)
+      if (name({i, Symbol::NonTerminator}) == name_)
+        return Symbol{i, Symbol::NonTerminator};
+    return std::nullopt;
+  }
+
+  [[nodiscard]] SymbolTable symbol_table() const {
+    SymbolTable symbols{};
+    for (u32 i = 2; i < T; ++i)
+      symbols.intern(name({i, Symbol::Terminator}), Symbol::Terminator);
+    for (u32 i = 0; i < N; ++i)
+      symbols.intern(
+          name({i, Symbol::NonTerminator}), Symbol::NonTerminator, origins[i]
+      );
+    return symbols;
+  }
+
+  [[nodiscard]] PredictionTable prediction_table() const {
+    PredictionTable table{T, N};
+    table.cells.assign(cells.begin(), cells.end());
+    table.follow.assign(follow.begin(), follow.end());
+    table.productions.assign(productions.begin(), productions.end());
+    table.rhs_pool.assign(rhs_pool.begin(), rhs_pool.end());
+    return table;
+  }
+};
+
+template<const std::string_view &Source>
+constexpr auto compile_static_grammar() {
+  constexpr auto shape = detail::compile_static_grammar(Source).shape();
+  StaticGrammar<
+      shape.terminator_count, shape.nonterminator_count,
+      shape.production_count, shape.rhs_pool_size, shape.name_pool_size>
+      grammar{};
+
+  auto builder = detail::compile_static_grammar(Source);
+  std::copy(builder.cells.begin(), builder.cells.end(), grammar.cells.begin());
+  std::copy(
+      builder.follow.begin(), builder.follow.end(), grammar.follow.begin()
+  );
+  std::copy(
+      builder.table_productions.begin(), builder.table_productions.end(),
+      grammar.productions.begin()
+  );
+  std::copy(
+      builder.rhs_pool.begin(), builder.rhs_pool.end(), grammar.rhs_pool.begin()
+  );
+
+  usize offset = 0, index = 0;
+  auto push_name = [&](const std::string &name) {
+    grammar.name_offsets[index++] = static_cast<u32>(offset);
+    std::copy(name.begin(), name.end(), grammar.name_pool.begin() + offset);
+    offset += name.size();
+  };
+  for (const auto &name : builder.terminator_names)
+    push_name(name);
+  for (const auto &name : builder.nonterminator_names)
+    push_name(name);
+  grammar.name_offsets[index] = static_cast<u32>(offset);
+  std::copy(
+      builder.nonterminator_origins.begin(),
+      builder.nonterminator_origins.end(), grammar.origins.begin()
+  );
+
+  return grammar;
+}
+
+// The LL(1) table of `Source`, built during compilation. `Source` must name
+// a `constexpr std::string_view` with static storage duration; a grammar that
+// is not LL(1) after the usual transformations fails to compile.
+template<const std::string_view &Source>
+inline constexpr auto static_grammar = compile_static_grammar<Source>();
+
+} // namespace ep
+
+#endif // EP_PARSER_STATIC_GRAMMAR_H
@@ -0,0 +1,121 @@
+#include "parser/stream_parser.h"
+
+#include "parser/driver.h"
+#include "simple_lexer/char_class.h"
+#include "simple_lexer/lexer.h"
+
+namespace ep {
+
+StreamParser::StreamParser(const CompiledGrammar &grammar): grammar_(grammar) {
+  reset();
+}
+
+void StreamParser::reset() {
+  stack_.clear();
+  stack_.push_back(Symbol::end_symbol());
+  stack_.push_back(grammar_.start_symbol());
+  pending_.clear();
+  pending_offset_ = offset_ = error_offset_ = 0;
+  status_ = Status::Pending;
+}
+
+void StreamParser::shift(Symbol symbol, usize offset) {
+  auto result = grammar_.visit_table([&](const auto &table) {
+    return ll1_step(table, symbol, stack_);
+  });
+  switch (result) {
+    case StepResult::Shifted:
+      break;
+    case StepResult::Accepted:
+      status_ = Status::Accepted;
+      break;
+    case StepResult::Rejected:
+      status_ = Status::Rejected;
+      error_offset_ = offset;
+      break;
+  }
+}
+
+void StreamParser::shift(const Token &token, usize offset) {
+  if (std::holds_alternative<Whitespace>(token))
+    return;
+  if (auto symbol = grammar_.lexeme_symbol(token); symbol) {
+    shift(*symbol, offset);
+  } else {
+    status_ = Status::Rejected;
+    error_offset_ = offset;
+  }
+}
+
+void StreamParser::flush_pending() {
+  if (pending_.empty())
+    return;
+  Lexer lexer(pending_);
+  shift(*lexer.next_token(), pending_offset_);
+  pending_.clear();
+}
+
+StreamParser::Status StreamParser::feed(std::string_view chunk) {
+  if (status_ != Status::Pending)
+    return status_;
+
+  // First let the chunk finish the token the last one was cut in.
+  usize pos = 0;
+  if (!pending_.empty()) {
+    auto run = has_class(pending_.front(), CharClass::digit)
+                   ? CharClass::digit
+                   : CharClass::identifier_part;
+    while (pos < chunk.size() && has_class(chunk[pos], run))
+      ++pos;
+    pending_.append(chunk.substr(0, pos));
+    if (pos == chunk.size()) {
+      offset_ += chunk.size();
+      return status_;
+    }
+    flush_pending();
+  }
+
+  auto rest = chunk.substr(pos);
+  Lexer lexer(rest);
+  for (std::optional<Token> token;
+       status_ == Status::Pending && (token = lexer.next_token());) {
+    auto [offset, length] = std::visit(
+        [](const auto &token) {
+          return token.span;
+        },
+        *token
+    );
+    // A token reaching the end of the chunk may go on in the next one.
+    bool cut = offset + length == rest.size() &&
+               (std::holds_alternative<Integer>(*token) ||
+                std::holds_alternative<Identifier>(*token));
+    if (cut) {
+      pending_.assign(rest.substr(offset));
+      pending_offset_ = offset_ + pos + offset;
+    } else {
+      shift(*token, offset_ + pos + offset);
+    }
+  }
+
+  offset_ += chunk.size();
+  return status_;
+}
+
+StreamParser::Status StreamParser::finish() {
+  if (status_ != Status::Pending)
+    return status_;
+  flush_pending();
+  if (status_ == Status::Pending)
+    shift(Symbol::end_symbol(), offset_);
+  return status_;
+}
+
+StreamParser::Status StreamParser::status() const {
+  return status_;
+}
+
+usize StreamParser::error_offset() const {
+  return error_offset_;
+}
+
+} // namespace ep
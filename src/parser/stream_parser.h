@@ -0,0 +1,69 @@
+#pragma once
+
+#ifndef EP_PARSER_STREAM_PARSER_H
+#  define EP_PARSER_STREAM_PARSER_H
+
+#  include "parser/parser.h"
+#  include "simple_lexer/token.h"
+#  include "util/type.h"
+
+#  include <string>
+#  include <string_view>
+#  include <vector>
+
+namespace ep {
+
+// Push interface to a `CompiledGrammar`: the source of one expression is fed in
+// chunks as it arrives, cut anywhere, and recognized on the fly. Between
+// calls only the LL stack and the token cut by the last chunk boundary are
+// kept, so memory is bounded by the nesting depth and the longest token
+// rather than by the length of the input.
+class StreamParser {
+public:
+  enum class Status {
+    Pending,  // Valid so far; more input, or `finish`, decides.
+    Accepted, // `finish` ended a complete expression.
+    Rejected, // The input cannot be completed; see `error_offset`.
+  };
+
+private:
+  const CompiledGrammar &grammar_;
+  std::vector<Symbol> stack_{};
+  // The integer or identifier the last chunk ended in, which the next chunk
+  // may continue, and the offset it starts at.
+  std::string pending_{};
+  usize pending_offset_{};
+  usize offset_{};
+  usize error_offset_{};
+  Status status_{Status::Pending};
+
+  void shift(const Token &token, usize offset);
+
+  void shift(Symbol symbol, usize offset);
+
+  void flush_pending();
+
+public:
+  // `grammar` must outlive the stream.
+  explicit StreamParser(const CompiledGrammar &grammar);
+
+  // Starts over on a new expression.
+  void reset();
+
+  // Feeds the next piece of the source. Once the status is no longer
+  // `Pending`, further input is ignored until `reset`.
+  Status feed(std::string_view chunk);
+
+  // Marks the end of the source.
+  Status finish();
+
+  [[nodiscard]] Status status() const;
+
+  // Byte offset into the whole source of the token that was rejected; the
+  // length of the source if it ended too early.
+  [[nodiscard]] usize error_offset() const;
+};
+
+} // namespace ep
+
+#endif // EP_PARSER_STREAM_PARSER_H
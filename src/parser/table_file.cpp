@@ -0,0 +1,236 @@
+#include "parser/table_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace ep {
+
+static_assert(sizeof(TableFileHeader) == 48);
+static_assert(sizeof(Symbol) == 8 && sizeof(Production) == 16);
+static_assert(std::is_trivially_copyable_v<Production>);
+
+namespace {
+
+constexpr usize section_alignment = 8;
+
+inline u64 fnv1a(std::string_view bytes) {
+  u64 hash = 0xcbf29ce484222325;
+  for (char c : bytes) {
+    hash ^= static_cast<u8>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+template<class T>
+void append_section(std::string &buf, std::span<const T> items) {
+  buf.append(
+      reinterpret_cast<const char *>(items.data()), items.size_bytes()
+  );
+  buf.resize((buf.size() + section_alignment - 1) & ~(section_alignment - 1));
+}
+
+// Hands out the sections of a mapped file in order, checking that each one
+// lies within it.
+class SectionReader {
+  std::string_view buf_;
+  usize pos_{};
+
+public:
+  explicit SectionReader(std::string_view buf): buf_(buf) {}
+
+  template<class T>
+  std::span<const T> next(usize count) {
+    if (count > (buf_.size() - pos_) / sizeof(T))
+      throw std::runtime_error("Table file is truncated");
+    std::span<const T> items{
+        reinterpret_cast<const T *>(buf_.data() + pos_), count
+    };
+    pos_ += (count * sizeof(T) + section_alignment - 1) &
+            ~(section_alignment - 1);
+    pos_ = std::min(pos_, buf_.size());
+    return items;
+  }
+};
+
+} // namespace
+
+void write_table_file(
+    const char *path, const SymbolTable &symbols,
+    const PredictionTable &prediction_table, Symbol start_symbol
+) {
+  std::vector<u32> name_offsets;
+  std::vector<SymbolOrigin> origins;
+  std::string name_pool;
+  auto push_name = [&](Symbol symbol) {
+    name_offsets.push_back(static_cast<u32>(name_pool.size()));
+    name_pool += symbols.name(symbol);
+  };
+  for (u32 i = 0; i < symbols.terminator_count(); ++i)
+    push_name({i, Symbol::Terminator});
+  for (u32 i = 0; i < symbols.nonterminator_count(); ++i) {
+    push_name({i, Symbol::NonTerminator});
+    origins.push_back(symbols.origin({i, Symbol::NonTerminator}));
+  }
+  name_offsets.push_back(static_cast<u32>(name_pool.size()));
+
+  TableFileHeader header{
+      .terminator_count = static_cast<u32>(prediction_table.terminator_count),
+      .nonterminator_count =
+          static_cast<u32>(prediction_table.nonterminator_count),
+      .production_count =
+          static_cast<u32>(prediction_table.productions.size()),
+      .rhs_pool_size = static_cast<u32>(prediction_table.rhs_pool.size()),
+      .name_pool_size = static_cast<u32>(name_pool.size()),
+      .start_symbol = start_symbol,
+  };
+  if (header.terminator_count != symbols.terminator_count() ||
+      header.nonterminator_count != symbols.nonterminator_count())
+    throw std::runtime_error("Prediction table does not match symbol table");
+  if (prediction_table.follow.size() != prediction_table.cells.size())
+    throw std::runtime_error("Prediction table has no FOLLOW sets");
+
+  std::string buf(sizeof header, '\0');
+  append_section(buf, std::span<const u32>(prediction_table.cells));
+  append_section(buf, std::span<const u8>(prediction_table.follow));
+  append_section(
+      buf, std::span<const Production>(prediction_table.productions)
+  );
+  append_section(buf, std::span<const Symbol>(prediction_table.rhs_pool));
+  append_section(buf, std::span<const u32>(name_offsets));
+  append_section(buf, std::span<const SymbolOrigin>(origins));
+  append_section(buf, std::span<const char>(name_pool));
+  header.checksum = fnv1a(std::string_view(buf).substr(sizeof header));
+  std::memcpy(buf.data(), &header, sizeof header);
+
+  auto temp_path = std::string(path) + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    if (!out.flush())
+      throw std::runtime_error(std::format("Cannot write {}", temp_path));
+  }
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec)
+    throw std::runtime_error(std::format("Cannot write {}", path));
+}
+
+TableFile::TableFile(const char *path): file_(path) {
+  auto contents = file_.contents();
+  TableFileHeader header;
+  if (contents.size() < sizeof header)
+    throw std::runtime_error(std::format("{} is not a table file", path));
+  std::memcpy(&header, contents.data(), sizeof header);
+  if (header.magic != TableFileHeader::magic_number)
+    throw std::runtime_error(std::format("{} is not a table file", path));
+  if (header.version != TableFileHeader::current_version)
+    throw std::runtime_error(std::format(
+        "{} has table format version {}, expected {}", path, header.version,
+        TableFileHeader::current_version
+    ));
+  contents.remove_prefix(sizeof header);
+  if (fnv1a(contents) != header.checksum)
+    throw std::runtime_error(std::format("{} fails its checksum", path));
+
+  terminator_count_ = header.terminator_count;
+  nonterminator_count_ = header.nonterminator_count;
+  start_symbol_ = header.start_symbol;
+  SectionReader sections(contents);
+  auto cell_count =
+      static_cast<usize>(header.nonterminator_count) * header.terminator_count;
+  cells_ = sections.next<u32>(cell_count);
+  follow_ = sections.next<u8>(cell_count);
+  productions_ = sections.next<Production>(header.production_count);
+  rhs_pool_ = sections.next<Symbol>(header.rhs_pool_size);
+  name_offsets_ = sections.next<u32>(
+      static_cast<usize>(header.terminator_count) +
+      header.nonterminator_count + 1
+  );
+  origins_ = sections.next<SymbolOrigin>(header.nonterminator_count);
+  name_pool_ = [&] {
+    auto pool = sections.next<char>(header.name_pool_size);
+    return std::string_view(pool.data(), pool.size());
+  }();
+
+  // The checksum only catches accidents; the parse loop indexes with these
+  // without further checks, so they must be in range whatever the file.
+  auto valid_symbol = [&](Symbol symbol) {
+    return symbol.type == Symbol::Terminator
+               ? symbol.id < terminator_count_
+               : symbol.type == Symbol::NonTerminator &&
+                     symbol.id < nonterminator_count_;
+  };
+  bool valid = terminator_count_ >= 2 &&
+               start_symbol_.type == Symbol::NonTerminator &&
+               valid_symbol(start_symbol_);
+  for (auto cell : cells_)
+    valid &= cell == PredictionTable::no_entry ||
+             cell < header.production_count;
+  for (const auto &[lhs, offset, length] : productions_)
+    valid &= valid_symbol(lhs) && offset <= rhs_pool_.size() &&
+             length <= rhs_pool_.size() - offset;
+  for (auto symbol : rhs_pool_)
+    valid &= valid_symbol(symbol);
+  valid &= std::is_sorted(name_offsets_.begin(), name_offsets_.end()) &&
+           name_offsets_.back() <= name_pool_.size();
+  for (auto origin : origins_)
+    valid &= origin <= SymbolOrigin::LeftFactoring;
+  if (!valid)
+    throw std::runtime_error(std::format("{} is corrupt", path));
+}
+
+std::string_view TableFile::name(Symbol symbol) const {
+  auto index = symbol.type == Symbol::Terminator
+                   ? symbol.id
+                   : terminator_count_ + symbol.id;
+  return name_pool_.substr(
+      name_offsets_[index], name_offsets_[index + 1] - name_offsets_[index]
+  );
+}
+
+std::optional<Symbol> TableFile::find(std::string_view name) const {
+  for (u32 i = 0; i < terminator_count_; ++i)
+    if (this->name({i, Symbol::Terminator}) == name)
+      return Symbol{i, Symbol::Terminator};
+  for (u32 i = 0; i < nonterminator_count_; ++i)
+    if (this->name({i, Symbol::NonTerminator}) == name)
+      return Symbol{i, Symbol::NonTerminator};
+  return std::nullopt;
+}
+
+usize TableFile::terminator_count() const {
+  return terminator_count_;
+}
+
+Symbol TableFile::start_symbol() const {
+  return start_symbol_;
+}
+
+SymbolTable TableFile::symbol_table() const {
+  SymbolTable symbols{};
+  for (u32 i = 2; i < terminator_count_; ++i)
+    symbols.intern(name({i, Symbol::Terminator}), Symbol::Terminator);
+  for (u32 i = 0; i < nonterminator_count_; ++i)
+    symbols.intern(
+        name({i, Symbol::NonTerminator}), Symbol::NonTerminator, origins_[i]
+    );
+  return symbols;
+}
+
+PredictionTable TableFile::prediction_table() const {
+  PredictionTable table{terminator_count_, nonterminator_count_};
+  table.cells.assign(cells_.begin(), cells_.end());
+  table.follow.assign(follow_.begin(), follow_.end());
+  table.productions.assign(productions_.begin(), productions_.end());
+  table.rhs_pool.assign(rhs_pool_.begin(), rhs_pool_.end());
+  return table;
+}
+
+} // namespace ep
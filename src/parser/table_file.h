@@ -0,0 +1,110 @@
+#pragma once
+
+#ifndef EP_PARSER_TABLE_FILE_H
+#  define EP_PARSER_TABLE_FILE_H
+
+#  include "parser/grammar.h"
+#  include "util/mapped_file.h"
+#  include "util/type.h"
+
+#  include <optional>
+#  include <span>
+#  include <string_view>
+
+namespace ep {
+
+// A compiled grammar saved to disk, so that a parser can start without
+// analyzing the grammar again. After the header come, each starting at a
+// multiple of 8 bytes and in host byte order:
+//
+//   u32          cells[nonterminator_count * terminator_count]
+//   u8           follow[nonterminator_count * terminator_count]
+//   Production   productions[production_count]
+//   Symbol       rhs_pool[rhs_pool_size]
+//   u32          name_offsets[terminator_count + nonterminator_count + 1]
+//   SymbolOrigin origins[nonterminator_count]
+//   char         name_pool[name_pool_size]
+//
+// which are the arrays of `StaticGrammar`. `checksum` is the 64-bit FNV-1a
+// hash of everything after the header.
+struct TableFileHeader {
+  static constexpr u32 magic_number = 0x42545045; // "EPTB" in little endian
+  static constexpr u32 current_version = 2;
+
+  u32 magic{magic_number};
+  u32 version{current_version};
+  u64 checksum{};
+  u32 terminator_count{};
+  u32 nonterminator_count{};
+  u32 production_count{};
+  u32 rhs_pool_size{};
+  u32 name_pool_size{};
+  u32 reserved{};
+  Symbol start_symbol{};
+};
+
+// Writes the table of a grammar to `path`, replacing the file atomically so
+// that processes mapping the old one are not disturbed. Throws
+// `std::runtime_error` on failure.
+void write_table_file(
+    const char *path, const SymbolTable &symbols,
+    const PredictionTable &prediction_table, Symbol start_symbol
+);
+
+// A table file mapped into memory. Exposes the same lookup interface as
+// `PredictionTable`, reading straight from the mapping, so that it is the
+// table `ll1_parse` and `ll1_step` run against, and the names of the
+// symbols, also read from the mapping. Moving it keeps the mapping and
+// every view into it.
+class TableFile {
+  MappedFile file_{};
+  Symbol start_symbol_{};
+  usize terminator_count_{};
+  usize nonterminator_count_{};
+  std::span<const u32> cells_{};
+  std::span<const u8> follow_{};
+  std::span<const Production> productions_{};
+  std::span<const Symbol> rhs_pool_{};
+  std::span<const u32> name_offsets_{};
+  std::span<const SymbolOrigin> origins_{};
+  std::string_view name_pool_{};
+
+public:
+  TableFile() = default;
+
+  // Throws `std::runtime_error` if the file cannot be mapped, is not a table
+  // file of the current version, or is truncated or corrupt.
+  explicit TableFile(const char *path);
+
+  [[nodiscard]] u32 lookup(Symbol nonterminator, Symbol terminator) const {
+    return cells_[nonterminator.id * terminator_count_ + terminator.id];
+  }
+
+  [[nodiscard]] bool
+  synchronizes(Symbol nonterminator, Symbol terminator) const {
+    return follow_[nonterminator.id * terminator_count_ + terminator.id] != 0;
+  }
+
+  [[nodiscard]] std::span<const Symbol> rhs(u32 production) const {
+    const auto &[_, offset, length] = productions_[production];
+    return rhs_pool_.subspan(offset, length);
+  }
+
+  [[nodiscard]] std::string_view name(Symbol symbol) const;
+
+  // Searches the names in the mapping, terminators first.
+  [[nodiscard]] std::optional<Symbol> find(std::string_view name) const;
+
+  [[nodiscard]] usize terminator_count() const;
+
+  [[nodiscard]] Symbol start_symbol() const;
+
+  // Copies of the mapped arrays, for what needs a table of its own.
+  [[nodiscard]] SymbolTable symbol_table() const;
+
+  [[nodiscard]] PredictionTable prediction_table() const;
+};
+
+} // namespace ep
+
+#endif // EP_PARSER_TABLE_FILE_H
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifndef EP_SIMPLE_LEXER_CHAR_CLASS_H
+#  define EP_SIMPLE_LEXER_CHAR_CLASS_H
+
+#  include "util/type.h"
+
+#  include <array>
+#  include <string_view>
+
+#  if defined(__AVX2__) || defined(__SSE2__)
+#    include <immintrin.h>
+#  endif
+
+namespace ep {
+
+// Bits of a character's class. Unlike the <cctype> predicates, these do not
+// depend on the locale and are defined for every byte, negative `char`s
+// included; bytes outside ASCII belong to no class.
+struct CharClass {
+  static constexpr u8 space = 1 << 0;            // " \t\n\v\f\r"
+  static constexpr u8 digit = 1 << 1;            // 0-9
+  static constexpr u8 identifier_start = 1 << 2; // letters and '_'
+  static constexpr u8 identifier_part = 1 << 3;  // letters, digits and '_'
+  static constexpr u8 punctuator = 1 << 4;       // "()+-*/"
+};
+
+inline constexpr auto char_classes = [] {
+  constexpr u8 letter =
+      CharClass::identifier_start | CharClass::identifier_part;
+  std::array<u8, 256> classes{};
+  for (auto c : std::string_view(" \t\n\v\f\r"))
+    classes[static_cast<u8>(c)] |= CharClass::space;
+  for (auto c = '0'; c <= '9'; ++c)
+    classes[static_cast<u8>(c)] |=
+        CharClass::digit | CharClass::identifier_part;
+  for (auto c = 'a'; c <= 'z'; ++c) {
+    classes[static_cast<u8>(c)] |= letter;
+    classes[static_cast<u8>(c - 'a' + 'A')] |= letter;
+  }
+  classes['_'] |= letter;
+  for (auto c : std::string_view("()+-*/"))
+    classes[static_cast<u8>(c)] |= CharClass::punctuator;
+  return classes;
+}();
+
+[[nodiscard]] inline constexpr bool has_class(char c, u8 classes) {
+  return char_classes[static_cast<u8>(c)] & classes;
+}
+
+namespace detail {
+
+// The end of the run of `Class` bytes starting at `pos`. `wide` classifies
+// `Width` bytes at once into a bit mask, set for the bytes in the run; the
+// remaining tail is looked up one byte at a time.
+template<usize Width, u8 Class, class Wide>
+inline usize scan_run(std::string_view src, usize pos, Wide &&wide) {
+  for (; pos + Width <= src.size(); pos += Width) {
+    if (u32 outside = ~wide(src.data() + pos); outside != 0)
+      return pos + __builtin_ctz(outside);
+  }
+  while (pos < src.size() && has_class(src[pos], Class))
+    ++pos;
+  return pos;
+}
+
+} // namespace detail
+
+// The end of the run of whitespace starting at `pos`.
+[[nodiscard]] inline usize skip_whitespace(std::string_view src, usize pos) {
+#  if defined(__AVX2__)
+  return detail::scan_run<32, CharClass::space>(src, pos, [](const char *p) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    // '\t'..'\r' are 9..13: (x - 9) <= 4 as unsigned bytes.
+    auto shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(9));
+    auto control = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted
+    );
+    auto blank = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+    return static_cast<u32>(
+        _mm256_movemask_epi8(_mm256_or_si256(control, blank))
+    );
+  });
+#  elif defined(__SSE2__)
+  return detail::scan_run<16, CharClass::space>(src, pos, [](const char *p) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    auto shifted = _mm_sub_epi8(x, _mm_set1_epi8(9));
+    auto control =
+        _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+    auto blank = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+    return static_cast<u32>(_mm_movemask_epi8(_mm_or_si128(control, blank))) |
+           0xffff0000u;
+  });
+#  else
+  while (pos < src.size() && has_class(src[pos], CharClass::space))
+    ++pos;
+  return pos;
+#  endif
+}
+
+// The end of the run of decimal digits starting at `pos`.
+[[nodiscard]] inline usize skip_digits(std::string_view src, usize pos) {
+#  if defined(__AVX2__)
+  return detail::scan_run<32, CharClass::digit>(src, pos, [](const char *p) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    auto shifted = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+    auto digit = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(shifted, _mm256_set1_epi8(9)), shifted
+    );
+    return static_cast<u32>(_mm256_movemask_epi8(digit));
+  });
+#  elif defined(__SSE2__)
+  return detail::scan_run<16, CharClass::digit>(src, pos, [](const char *p) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    auto shifted = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    auto digit =
+        _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(9)), shifted);
+    return static_cast<u32>(_mm_movemask_epi8(digit)) | 0xffff0000u;
+  });
+#  else
+  while (pos < src.size() && has_class(src[pos], CharClass::digit))
+    ++pos;
+  return pos;
+#  endif
+}
+
+} // namespace ep
+
+#endif // EP_SIMPLE_LEXER_CHAR_CLASS_H
@@ -1,16 +1,15 @@
 #include "simple_lexer/lexer.h"
 
-#include <cctype>
-#include <set>
+#include "simple_lexer/char_class.h"
 
 namespace ep {
 
-Lexer::Lexer(std::string str): src_(std::move(str)) {}
+Lexer::Lexer(std::string_view src): src_(src) {}
 
 std::optional<char> Lexer::peek(usize offset) const {
   if (pos_ + offset >= src_.size())
     return std::nullopt;
-  return src_.at(pos_ + offset);
+  return src_[pos_ + offset];
 }
 
 bool Lexer::reached_eof() const {
@@ -20,38 +19,72 @@ bool Lexer::reached_eof() const {
 std::optional<char> Lexer::consume() {
   if (reached_eof())
     return std::nullopt;
-  return src_.at(pos_++);
+  return src_[pos_++];
+}
+
+Span Lexer::span() const {
+  return {
+      static_cast<u32>(token_start_), static_cast<u32>(pos_ - token_start_)
+  };
 }
 
 std::optional<Token> Lexer::next_token() {
+  token_start_ = pos_;
   auto cur_char = consume();
   if (!cur_char)
     return std::nullopt;
 
-  if (isspace(*cur_char))
+  auto classes = char_classes[static_cast<u8>(*cur_char)];
+  if (classes & CharClass::space)
     return consume_whitespace();
-  if (isdigit(*cur_char))
+  if (classes & CharClass::digit)
     return consume_integer();
+  if (classes & CharClass::identifier_start)
+    return consume_identifier();
   return punctuator(*cur_char);
 }
 
+std::string_view Lexer::source() const {
+  return src_;
+}
+
 Token Lexer::consume_whitespace() {
-  while (peek() && isspace(*peek()))
-    consume();
-  return Whitespace{};
+  pos_ = skip_whitespace(src_, pos_);
+  return Whitespace{span()};
 }
 
 Token Lexer::consume_integer() {
-  while (peek() && isdigit(*peek()))
-    consume();
-  return Integer{};
+  pos_ = skip_digits(src_, pos_);
+  auto digits = src_.substr(token_start_, pos_ - token_start_);
+
+  // Up to 18 digits always fit in an `i64`; only longer runs are checked.
+  i64 value = 0;
+  if (digits.size() <= 18) {
+    for (auto c : digits)
+      value = value * 10 + (c - '0');
+    return Integer{value, span()};
+  }
+  bool overflow = false;
+  for (auto c : digits) {
+    overflow |= __builtin_mul_overflow(value, 10, &value);
+    overflow |= __builtin_add_overflow(value, c - '0', &value);
+  }
+  if (overflow)
+    return LexError{span()};
+  return Integer{value, span()};
+}
+
+Token Lexer::consume_identifier() {
+  while (pos_ < src_.size() &&
+         has_class(src_[pos_], CharClass::identifier_part))
+    ++pos_;
+  return Identifier{span()};
 }
 
-Token Lexer::punctuator(char c) {
-  static std::set<char> valid_punctuators{'(', ')', '+', '-', '*', '/'};
-  if (valid_punctuators.contains(c))
-    return Punctuator{c};
-  return LexError{};
+Token Lexer::punctuator(char c) const {
+  if (has_class(c, CharClass::punctuator))
+    return Punctuator{c, span()};
+  return LexError{span()};
 }
 
 } // namespace ep
@@ -7,17 +7,23 @@
 #  include "util/all.h"
 
 #  include <optional>
+#  include <string_view>
 
 namespace ep {
 
+// Splits a source into tokens without copying it. The lexer only views the
+// source, which must outlive it; token spans are offsets into that view.
 class Lexer {
   usize pos_{};
-  std::string src_{};
+  usize token_start_{};
+  std::string_view src_{};
+
+  [[nodiscard]] Span span() const;
 
 public:
   Lexer() = default;
 
-  explicit Lexer(std::string str);
+  explicit Lexer(std::string_view src);
 
   Lexer(const Lexer &rhs) = delete;
 
@@ -29,6 +35,8 @@ public:
 
   [[nodiscard]] std::optional<Token> next_token();
 
+  [[nodiscard]] std::string_view source() const;
+
   [[nodiscard]] bool reached_eof() const;
 
   [[nodiscard]] std::optional<char> peek(usize offset = 0) const;
@@ -39,7 +47,9 @@ public:
 
   [[nodiscard]] Token consume_integer();
 
-  [[nodiscard]] static Token punctuator(char first_char);
+  [[nodiscard]] Token consume_identifier();
+
+  [[nodiscard]] Token punctuator(char first_char) const;
 };
 
 } // namespace ep
@@ -3,6 +3,8 @@
 #ifndef EP_SIMPLE_LEXER_TOKEN_H
 #  define EP_SIMPLE_LEXER_TOKEN_H
 
+#  include "util/type.h"
+
 #  include <string_view>
 #  include <variant>
 
@@ -10,25 +12,45 @@ namespace ep {
 
 // enum class TokenBase : u8 {
 //   Integer
+//   Identifier,
 //   Punctuator,
 //   // Non-language tokens
 //   Whitespace,
 //   LexError,
 // };
 
-struct Integer {};
+// Where a token lies in the source, in bytes.
+struct Span {
+  u32 offset{};
+  u32 length{};
+};
+
+struct Integer {
+  i64 value{};
+  Span span{};
+};
+
+struct Identifier {
+  Span span{};
+};
 
 struct Punctuator {
   char punct{};
+  Span span{};
 
-  explicit Punctuator(char punct): punct(punct) {}
+  explicit Punctuator(char punct, Span span = {}): punct(punct), span(span) {}
 };
 
-struct Whitespace {};
+struct Whitespace {
+  Span span{};
+};
 
-struct LexError {};
+struct LexError {
+  Span span{};
+};
 
-using Token = std::variant<Integer, Punctuator, Whitespace, LexError>;
+using Token =
+    std::variant<Integer, Identifier, Punctuator, Whitespace, LexError>;
 
 } // namespace ep
 
@@ -3,6 +3,7 @@
 #ifndef EP_UTIL_ALL_H
 #  define EP_UTIL_ALL_H
 
+#  include "util/arena.h"
 #  include "util/functional.h"
 #  include "util/overloaded.h"
 #  include "util/type.h"
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef EP_UTIL_ARENA_H
+#  define EP_UTIL_ARENA_H
+
+#  include "util/type.h"
+
+#  include <memory>
+#  include <type_traits>
+#  include <vector>
+
+namespace ep {
+
+// Bump allocator handing out `u32` indices into fixed-size chunks. `reset`
+// rewinds it without releasing the chunks, so an arena reused across inputs
+// stops allocating once it has grown to the largest input.
+template<class T, usize ChunkSize = 4096>
+class Arena {
+  static_assert(std::is_trivially_destructible_v<T>);
+
+  std::vector<std::unique_ptr<T[]>> chunks_{};
+  usize size_{};
+
+public:
+  Arena() = default;
+
+  Arena(const Arena &rhs) = delete;
+
+  Arena(Arena &&rhs) noexcept = default;
+
+  Arena &operator=(const Arena &rhs) = delete;
+
+  Arena &operator=(Arena &&rhs) noexcept = default;
+
+  u32 allocate(const T &value) {
+    if (size_ == chunks_.size() * ChunkSize)
+      chunks_.emplace_back(std::make_unique_for_overwrite<T[]>(ChunkSize));
+    chunks_[size_ / ChunkSize][size_ % ChunkSize] = value;
+    return static_cast<u32>(size_++);
+  }
+
+  [[nodiscard]] T &operator[](u32 index) {
+    return chunks_[index / ChunkSize][index % ChunkSize];
+  }
+
+  [[nodiscard]] const T &operator[](u32 index) const {
+    return chunks_[index / ChunkSize][index % ChunkSize];
+  }
+
+  [[nodiscard]] usize size() const {
+    return size_;
+  }
+
+  [[nodiscard]] usize capacity() const {
+    return chunks_.size() * ChunkSize;
+  }
+
+  void reset() {
+    size_ = 0;
+  }
+};
+
+} // namespace ep
+
+#endif // EP_UTIL_ARENA_H
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifndef EP_UTIL_HISTOGRAM_H
+#  define EP_UTIL_HISTOGRAM_H
+
+#  include "util/type.h"
+
+#  include <algorithm>
+#  include <array>
+#  include <bit>
+#  include <cmath>
+
+namespace ep {
+
+// Histogram of durations in nanoseconds with log-linear buckets: each power
+// of two is split into `sub_buckets` equal parts, so a percentile is off by
+// at most 1/8 of the value. Recording is a few instructions and never
+// allocates; histograms of several threads are combined with `merge`.
+class LatencyHistogram {
+  static constexpr u32 sub_bits = 3;
+  static constexpr u32 sub_buckets = 1u << sub_bits;
+  // Values below `sub_buckets` get a bucket each; above, every power of two
+  // up to 2^63 gets `sub_buckets`.
+  static constexpr usize bucket_count = (64 - sub_bits + 1) * sub_buckets;
+
+  std::array<u64, bucket_count> buckets_{};
+  u64 count_{};
+  u64 max_{};
+
+  static usize bucket_of(u64 value) {
+    if (value < sub_buckets)
+      return value;
+    u32 exponent = std::bit_width(value) - 1;
+    u32 shift = exponent - sub_bits;
+    return (shift + 1) * sub_buckets + ((value >> shift) & (sub_buckets - 1));
+  }
+
+  // The largest value falling into bucket `index`.
+  static u64 bucket_max(usize index) {
+    if (index < sub_buckets)
+      return index;
+    u32 shift = static_cast<u32>(index / sub_buckets) - 1;
+    u64 low = (sub_buckets | index % sub_buckets) << shift;
+    return low + ((u64{1} << shift) - 1);
+  }
+
+public:
+  void record(u64 nanoseconds) {
+    ++buckets_[bucket_of(nanoseconds)];
+    ++count_;
+    max_ = std::max(max_, nanoseconds);
+  }
+
+  void merge(const LatencyHistogram &rhs) {
+    for (usize i = 0; i < bucket_count; ++i)
+      buckets_[i] += rhs.buckets_[i];
+    count_ += rhs.count_;
+    max_ = std::max(max_, rhs.max_);
+  }
+
+  [[nodiscard]] u64 count() const {
+    return count_;
+  }
+
+  [[nodiscard]] u64 max() const {
+    return max_;
+  }
+
+  // The value below which a share `p` (0 to 1) of the recordings fall,
+  // rounded up to its bucket; 0 if nothing was recorded.
+  [[nodiscard]] u64 percentile(double p) const {
+    if (count_ == 0)
+      return 0;
+    auto rank = static_cast<u64>(
+        std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(count_))
+    );
+    rank = std::max<u64>(rank, 1);
+    u64 seen = 0;
+    for (usize i = 0; i < bucket_count; ++i)
+      if ((seen += buckets_[i]) >= rank)
+        return std::min(bucket_max(i), max_);
+    return max_;
+  }
+};
+
+} // namespace ep
+
+#endif // EP_UTIL_HISTOGRAM_H
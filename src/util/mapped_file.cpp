@@ -0,0 +1,79 @@
+#include "util/mapped_file.h"
+
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ep {
+
+MappedFile::MappedFile(const char *path) {
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error(std::format("Cannot open {}", path));
+
+  struct stat st {};
+  if (::fstat(fd, &st) < 0) {
+    ::close(fd);
+    throw std::runtime_error(std::format("Cannot stat {}", path));
+  }
+
+  // `mmap` rejects an empty mapping; an empty file simply has no contents.
+  size_ = static_cast<usize>(st.st_size);
+  if (size_ != 0) {
+    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error(std::format("Cannot map {}", path));
+    }
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(addr);
+  }
+  // The mapping outlives the descriptor.
+  ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile &&rhs) noexcept:
+    data_(std::exchange(rhs.data_, nullptr)),
+    size_(std::exchange(rhs.size_, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&rhs) noexcept {
+  if (this != &rhs) {
+    this->~MappedFile();
+    data_ = std::exchange(rhs.data_, nullptr);
+    size_ = std::exchange(rhs.size_, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (data_)
+    ::munmap(const_cast<char *>(data_), size_);
+}
+
+std::string_view MappedFile::contents() const {
+  return {data_, size_};
+}
+
+LineReader::LineReader(std::string_view buf): buf_(buf) {}
+
+std::optional<std::string_view> LineReader::next_line() {
+  if (pos_ >= buf_.size())
+    return std::nullopt;
+
+  auto end = buf_.find('\n', pos_);
+  if (end == std::string_view::npos)
+    end = buf_.size();
+  auto line = buf_.substr(pos_, end - pos_);
+  pos_ = end + 1;
+
+  if (!line.empty() && line.back() == '\r')
+    line.remove_suffix(1);
+  return line;
+}
+
+} // namespace ep
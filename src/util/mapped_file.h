@@ -0,0 +1,55 @@
+#pragma once
+
+#ifndef EP_UTIL_MAPPED_FILE_H
+#  define EP_UTIL_MAPPED_FILE_H
+
+#  include "util/type.h"
+
+#  include <optional>
+#  include <string_view>
+
+namespace ep {
+
+// A file mapped read-only into memory, for handing out views of its bytes
+// without reading them into a buffer first. The views stay valid for as
+// long as the `MappedFile` lives.
+class MappedFile {
+  const char *data_{};
+  usize size_{};
+
+public:
+  MappedFile() = default;
+
+  // Throws `std::runtime_error` if the file cannot be opened or mapped.
+  explicit MappedFile(const char *path);
+
+  MappedFile(const MappedFile &rhs) = delete;
+
+  MappedFile(MappedFile &&rhs) noexcept;
+
+  MappedFile &operator=(const MappedFile &rhs) = delete;
+
+  MappedFile &operator=(MappedFile &&rhs) noexcept;
+
+  ~MappedFile();
+
+  [[nodiscard]] std::string_view contents() const;
+};
+
+// Hands out the lines of a buffer one at a time as views into it, without
+// the line terminators ("\n" or "\r\n").
+class LineReader {
+  std::string_view buf_{};
+  usize pos_{};
+
+public:
+  LineReader() = default;
+
+  explicit LineReader(std::string_view buf);
+
+  [[nodiscard]] std::optional<std::string_view> next_line();
+};
+
+} // namespace ep
+
+#endif // EP_UTIL_MAPPED_FILE_H
@@ -0,0 +1,96 @@
+#include "util/thread_pool.h"
+
+#include <algorithm>
+
+namespace ep {
+
+ThreadPool::ThreadPool(usize threads) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  for (usize i = 0; i < threads; ++i)
+    queues_.push_back(std::make_unique<Queue>());
+  for (usize i = 0; i < threads; ++i)
+    threads_.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (auto &thread : threads_)
+    thread.join();
+}
+
+usize ThreadPool::size() const {
+  return threads_.size();
+}
+
+void ThreadPool::submit(Task task) {
+  // Counted before it can be taken, so that the counts never go negative.
+  {
+    std::lock_guard lock(mutex_);
+    ++unfinished_;
+    ++queued_;
+  }
+  {
+    auto &queue = *queues_[next_queue_++ % queues_.size()];
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  work_available_.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock lock(mutex_);
+  all_done_.wait(lock, [&] {
+    return unfinished_ == 0;
+  });
+}
+
+bool ThreadPool::pop(usize worker, Task &task) {
+  {
+    auto &own = *queues_[worker];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (usize i = 1; i < queues_.size(); ++i) {
+    auto &victim = *queues_[(worker + i) % queues_.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::work(usize worker) {
+  for (Task task;;) {
+    if (pop(worker, task)) {
+      --queued_;
+      task(worker);
+      task = nullptr;
+      std::lock_guard lock(mutex_);
+      if (--unfinished_ == 0)
+        all_done_.notify_all();
+      continue;
+    }
+
+    std::unique_lock lock(mutex_);
+    work_available_.wait(lock, [&] {
+      return stopping_ || queued_ != 0;
+    });
+    if (stopping_ && queued_ == 0)
+      return;
+  }
+}
+
+} // namespace ep
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef EP_UTIL_THREAD_POOL_H
+#  define EP_UTIL_THREAD_POOL_H
+
+#  include "util/type.h"
+
+#  include <atomic>
+#  include <condition_variable>
+#  include <deque>
+#  include <functional>
+#  include <memory>
+#  include <mutex>
+#  include <thread>
+#  include <vector>
+
+namespace ep {
+
+// Fixed set of worker threads, each with its own task queue. A worker runs
+// its own tasks newest first, and once out of them steals the oldest tasks
+// of the others, so that uneven tasks still keep every thread busy. Tasks
+// are submitted and waited for by the thread owning the pool.
+class ThreadPool {
+public:
+  // A task is given the index of the worker running it, for indexing
+  // per-worker state.
+  using Task = std::function<void(usize worker)>;
+
+private:
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<Task> tasks{};
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues_{};
+  std::vector<std::thread> threads_{};
+  usize next_queue_{};
+
+  std::mutex mutex_{};
+  std::condition_variable work_available_{};
+  std::condition_variable all_done_{};
+  // Tasks queued but not yet taken, and tasks not yet finished.
+  std::atomic<usize> queued_{};
+  usize unfinished_{};
+  bool stopping_{};
+
+  bool pop(usize worker, Task &task);
+
+  void work(usize worker);
+
+public:
+  // Zero threads means one per hardware thread.
+  explicit ThreadPool(usize threads = 0);
+
+  ThreadPool(const ThreadPool &rhs) = delete;
+
+  ThreadPool &operator=(const ThreadPool &rhs) = delete;
+
+  // Finishes the queued tasks before joining the workers.
+  ~ThreadPool();
+
+  [[nodiscard]] usize size() const;
+
+  void submit(Task task);
+
+  // Blocks until every task submitted so far has finished.
+  void wait();
+};
+
+} // namespace ep
+
+#endif // EP_UTIL_THREAD_POOL_H
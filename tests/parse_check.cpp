@@ -0,0 +1,251 @@
+// End-to-end checks of `ParseSession`, `ll1_parse` and table files over
+// inputs that the benches do not generate. Each check prints what it found
+// wrong; the exit status is failure if any did.
+//
+//   parse_check
+
+#include "parser/parser.h"
+#include "workload.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace ep;
+
+namespace {
+
+bool failed = false;
+
+void expect(bool ok, std::string_view what) {
+  if (!ok) {
+    std::cout << std::format("FAILED: {}\n", what);
+    failed = true;
+  }
+}
+
+constexpr const auto &static_table = static_grammar<bench::expression_grammar>;
+
+// Whether the terminators named by `names` make a sentence, by `ll1_parse`
+// on the arrays of `static_table` in constant evaluation.
+constexpr bool
+static_accepts(std::initializer_list<std::string_view> names) {
+  std::vector<Symbol> input, stack;
+  for (auto name : names)
+    input.push_back(*static_table.find(name));
+  input.push_back(Symbol::end_symbol());
+  return ll1_parse(
+      static_table, static_table.start_symbol, std::span<const Symbol>(input),
+      stack, Recognizer{}
+  );
+}
+
+static_assert(static_accepts({"n", "+", "(", "id", "*", "n", ")"}));
+static_assert(!static_accepts({"n", "+", "*", "n"}));
+static_assert(!static_accepts({"(", "n"}));
+
+std::string
+run(const CompiledGrammar &grammar, ParseMode mode, std::string_view src) {
+  ParseSession session(grammar);
+  session.set_mode(mode);
+  std::string out;
+  session.run(src, out);
+  return out;
+}
+
+// The tree walks of `build_ast`, `append_string` and `compile` keep their
+// own stacks, so nesting far deeper than the call stack could take parses
+// like any other input.
+void check_deep_nesting(const CompiledGrammar &grammar) {
+  constexpr usize depth = 100000;
+
+  std::string parenthesized(depth, '(');
+  parenthesized.append("7").append(depth, ')');
+  expect(
+      run(grammar, ParseMode::Ast, parenthesized) == "n\n",
+      "AST of a deeply parenthesized operand"
+  );
+  expect(
+      run(grammar, ParseMode::Evaluate, parenthesized) == "7\n",
+      "value of a deeply parenthesized operand"
+  );
+
+  // `1+(1+(1+...))`: every level adds an operator node to the AST.
+  std::string nested;
+  for (usize i = 0; i < depth; ++i)
+    nested.append("1+(");
+  nested.append("1").append(depth, ')');
+  expect(
+      run(grammar, ParseMode::Evaluate, nested) ==
+          std::format("{}\n", depth + 1),
+      "value of deeply nested sums"
+  );
+  expect(
+      run(grammar, ParseMode::Compile, nested).starts_with("const"),
+      "bytecode of deeply nested sums"
+  );
+  auto ast = run(grammar, ParseMode::Ast, nested);
+  expect(
+      ast.starts_with("(+ n (+ n") &&
+          ast.ends_with("n n" + std::string(depth, ')') + "\n"),
+      "AST of deeply nested sums"
+  );
+}
+
+// The expression grammar analyzed at run time, without the printing of
+// `CompiledGrammar(Grammar)`.
+CompiledGrammar runtime_grammar() {
+  auto source = Grammar::from_str(bench::expression_grammar);
+  source.eliminate_left_recursion();
+  source.extract_left_factoring();
+  auto start_symbol = Symbol{0, Symbol::NonTerminator};
+  auto table = source.build_prediction_table(start_symbol);
+  return CompiledGrammar(source.symbols, std::move(table), start_symbol);
+}
+
+// The terminators of `line` in `grammar`, ending with `$`.
+std::vector<Symbol>
+symbols_of(const CompiledGrammar &grammar, std::string_view line) {
+  std::vector<Token> tokens;
+  Lexer lexer(line);
+  for (std::optional<Token> token; (token = lexer.next_token());)
+    tokens.push_back(*token);
+  auto symbols = grammar.convert_lexeme_to_symbol(tokens);
+  symbols.push_back(Symbol::end_symbol());
+  return symbols;
+}
+
+// `ll1_parse` on `static_table` derives generated lines, erroneous ones
+// included, step for step like it does on the table that the runtime
+// analysis builds from the same source.
+void check_static_against_runtime(const CompiledGrammar &runtime) {
+  bench::ExpressionGenerator generator({.error_rate = 0.2}, 1);
+  std::vector<Symbol> stack;
+  Derivation from_static, from_runtime;
+  usize mismatches = 0;
+  for (usize i = 0; i < 10000; ++i) {
+    std::string line;
+    generator.append_expression(line);
+    auto symbols = symbols_of(runtime, line);
+
+    from_static.steps.clear();
+    from_static.accepted = ll1_parse(
+        static_table, static_table.start_symbol, std::span(symbols), stack,
+        DerivationRecorder{from_static.steps}
+    );
+    from_runtime.steps.clear();
+    from_runtime.accepted = ll1_parse(
+        runtime.prediction_table(), runtime.start_symbol(), std::span(symbols),
+        stack, DerivationRecorder{from_runtime.steps}
+    );
+    mismatches += from_static.accepted != from_runtime.accepted ||
+                  from_static.steps != from_runtime.steps;
+  }
+  expect(mismatches == 0, "static and runtime derivations");
+}
+
+// Whether `TableFile` takes the file at `path`.
+bool loads(const std::filesystem::path &path) {
+  try {
+    TableFile table_file(path.c_str());
+    return true;
+  } catch (const std::runtime_error &) {
+    return false;
+  }
+}
+
+void write_bytes(const std::filesystem::path &path, std::string_view bytes) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// A table saved by `write_table_file` and parsed against in its mapping
+// gives the terminators, derivations and results of the runtime table it
+// was saved from, and a damaged one is refused.
+void check_table_file(const CompiledGrammar &runtime) {
+  auto dir = std::filesystem::temp_directory_path();
+  auto path = dir / std::format("parse_check_{}.table", ::getpid());
+  auto damaged = dir / std::format("parse_check_{}.damaged", ::getpid());
+  write_table_file(
+      path.c_str(), runtime.symbols(), runtime.prediction_table(),
+      runtime.start_symbol()
+  );
+  CompiledGrammar loaded{TableFile(path.c_str())};
+  expect(
+      loaded.prediction_table().cells.empty(),
+      "no prediction table copied out of the table file"
+  );
+
+  bench::ExpressionGenerator generator({.error_rate = 0.2}, 2);
+  usize mismatches = 0;
+  for (usize i = 0; i < 10000; ++i) {
+    std::string line;
+    generator.append_expression(line);
+    auto symbols = symbols_of(runtime, line);
+    auto from_file = loaded.derive(symbols_of(loaded, line));
+    auto from_runtime = runtime.derive(symbols);
+    mismatches += symbols_of(loaded, line) != symbols ||
+                  from_file.accepted != from_runtime.accepted ||
+                  from_file.steps != from_runtime.steps;
+    if (i < 200)
+      for (auto mode : {ParseMode::Ast, ParseMode::Evaluate})
+        mismatches += run(loaded, mode, line) != run(runtime, mode, line);
+  }
+  expect(mismatches == 0, "table file and runtime derivations");
+
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  expect(loads(path), "loading an intact table file");
+
+  auto flipped = bytes;
+  flipped[flipped.size() - 1] ^= 1;
+  write_bytes(damaged, flipped);
+  expect(!loads(damaged), "rejecting a table file with a flipped byte");
+
+  auto versioned = bytes;
+  auto version = TableFileHeader::current_version + 1;
+  std::memcpy(
+      versioned.data() + offsetof(TableFileHeader, version), &version,
+      sizeof version
+  );
+  write_bytes(damaged, versioned);
+  expect(!loads(damaged), "rejecting a table file of another version");
+
+  for (usize size : {bytes.size() / 2, sizeof(TableFileHeader) - 1}) {
+    write_bytes(damaged, std::string_view(bytes).substr(0, size));
+    expect(
+        !loads(damaged),
+        std::format("rejecting a table file truncated to {} bytes", size)
+    );
+  }
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(damaged);
+}
+
+} // namespace
+
+int main() {
+  CompiledGrammar grammar(static_table);
+  check_deep_nesting(grammar);
+  auto runtime = runtime_grammar();
+  check_static_against_runtime(runtime);
+  check_table_file(runtime);
+  if (!failed)
+    std::cout << "All checks passed\n";
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+// Generates a random grammar in the format of `Grammar::from_str` that is
+// LL(1) once left recursion is eliminated and common prefixes factored out,
+// for scaling tests of the analysis pipeline (see `bench --grammar`).
+//
+// LL(1) is guaranteed by construction. Terminators come in two kinds: lead
+// terminators start alternatives, and separators follow every nonterminator
+// that is not last in its alternative. So every FOLLOW set holds separators
+// and `$` only, while every FIRST set holds lead terminators only, and the
+// alternatives of a nonterminator start with disjoint sets of them:
+//
+//  - a plain alternative starts with a lead terminator of its own, or with a
+//    nonterminator defined further down whose FIRST set is still unclaimed;
+//  - a nullable nonterminator has an `ε` alternative besides;
+//  - a left-recursive nonterminator has alternatives `A t ...` besides, each
+//    with a lead `t` of its own;
+//  - a common prefix is a group of alternatives `t u ... v ...` sharing
+//    their first few terminators, then each with a lead `v` of its own.
+//
+// Nonterminator `Na` is the start symbol. Each nonterminator is referenced
+// from its first alternative by one defined above it, so that all are
+// reachable, and that alternative only references nonterminators below, so
+// that all derive some sentence. Names end in a letter, as the
+// transformations name their nonterminators by appending `'` or a digit.
+//
+//   grammar_gen [--nonterminals N] [--terminals N] [--separators N]
+//               [--alternatives N] [--length N] [--nullable P]
+//               [--left-recursive P] [--common-prefix P] [--seed N]
+
+#include "util/type.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+struct Options {
+  usize nonterminators = 100;
+  usize terminators = 32; // Lead terminators.
+  usize separators = 8;
+  usize alternatives = 4; // Plain alternatives per nonterminator, at most.
+  usize length = 4;       // Symbols after the lead, at most.
+  double nullable = 0.1;
+  double left_recursive = 0.1;
+  double common_prefix = 0.2;
+  u64 seed = 1;
+};
+
+std::string nonterminator_name(usize index) {
+  std::string suffix;
+  do {
+    suffix.insert(suffix.begin(), static_cast<char>('a' + index % 26));
+    index /= 26;
+  } while (index-- != 0);
+  return "N" + suffix;
+}
+
+class Generator {
+  Options options_;
+  std::mt19937_64 rng_;
+  std::vector<std::set<usize>> first_{};
+  std::vector<bool> nullable_{};
+  // The nonterminators each one references in its first alternative.
+  std::vector<std::vector<usize>> children_{};
+
+  bool roll(double p) {
+    return std::bernoulli_distribution(p)(rng_);
+  }
+
+  usize pick(usize lo, usize hi) {
+    return std::uniform_int_distribution<usize>(lo, hi)(rng_);
+  }
+
+  std::string lead(usize t) const {
+    return std::format("t{}", t);
+  }
+
+  std::string separator() {
+    return std::format("s{}", pick(0, options_.separators - 1));
+  }
+
+  // A lead terminator not in `claimed`, which it is added to; there is
+  // always one, as a nonterminator never needs more leads than the options
+  // allow.
+  usize claim_lead(std::set<usize> &claimed) {
+    usize t;
+    do
+      t = pick(0, options_.terminators - 1);
+    while (claimed.contains(t));
+    claimed.insert(t);
+    return t;
+  }
+
+  // Random symbols after the lead of an alternative, referencing
+  // nonterminators from `lo` on. Each nonterminator is followed by a
+  // separator, unless it comes last and the alternative is `closed`.
+  // Eliminating left recursion appends to every alternative of the
+  // nonterminator, so those must not be closed.
+  void append_body(std::vector<std::string> &rhs, usize lo, bool closed) {
+    for (usize k = pick(0, options_.length); k > 0; --k) {
+      if (lo < options_.nonterminators && roll(0.5)) {
+        rhs.push_back(nonterminator_name(pick(lo, options_.nonterminators - 1))
+        );
+        if (k > 1 || !closed)
+          rhs.push_back(separator());
+      } else if (roll(0.5)) {
+        rhs.push_back(lead(pick(0, options_.terminators - 1)));
+      } else {
+        rhs.push_back(separator());
+      }
+    }
+  }
+
+  std::vector<std::vector<std::string>> alternatives(usize self) {
+    std::vector<std::vector<std::string>> alternatives;
+    std::set<usize> claimed;
+    bool left_recursive = roll(options_.left_recursive);
+    bool closed = !left_recursive;
+
+    // The first alternative reaches the children and nothing above.
+    {
+      auto t = claim_lead(claimed);
+      std::vector<std::string> rhs{lead(t)};
+      first_[self].insert(t);
+      for (usize child : children_[self]) {
+        rhs.push_back(nonterminator_name(child));
+        rhs.push_back(separator());
+      }
+      append_body(rhs, self + 1, closed);
+      alternatives.push_back(std::move(rhs));
+    }
+
+    for (usize a = pick(1, options_.alternatives) - 1; a > 0; --a) {
+      std::vector<std::string> rhs;
+      // Start with a nonterminator further down if one has a FIRST set
+      // disjoint from the claimed leads, leaving enough leads for the rest;
+      // a few tries are enough.
+      usize start = self;
+      for (int tries = 0; tries < 4 && start == self; ++tries) {
+        if (self + 1 >= options_.nonterminators || !roll(0.3))
+          break;
+        auto candidate = pick(self + 1, options_.nonterminators - 1);
+        if (nullable_[candidate] ||
+            claimed.size() + first_[candidate].size() + a + 1 >
+                options_.terminators)
+          continue;
+        if (std::none_of(
+                first_[candidate].begin(), first_[candidate].end(),
+                [&](usize t) {
+                  return claimed.contains(t);
+                }
+            ))
+          start = candidate;
+      }
+      if (start != self) {
+        claimed.insert(first_[start].begin(), first_[start].end());
+        first_[self].insert(first_[start].begin(), first_[start].end());
+        rhs.push_back(nonterminator_name(start));
+        rhs.push_back(separator());
+      } else {
+        auto t = claim_lead(claimed);
+        first_[self].insert(t);
+        rhs.push_back(lead(t));
+      }
+      append_body(rhs, 0, closed);
+      alternatives.push_back(std::move(rhs));
+    }
+
+    if (roll(options_.common_prefix)) {
+      auto t = claim_lead(claimed);
+      first_[self].insert(t);
+      std::vector<std::string> prefix{lead(t)};
+      for (usize k = pick(0, 2); k > 0; --k)
+        prefix.push_back(
+            roll(0.5) ? lead(pick(0, options_.terminators - 1)) : separator()
+        );
+      std::set<usize> tails;
+      for (usize k = pick(2, 3); k > 0; --k) {
+        auto rhs = prefix;
+        rhs.push_back(lead(claim_lead(tails)));
+        append_body(rhs, 0, closed);
+        alternatives.push_back(std::move(rhs));
+      }
+    }
+
+    if (left_recursive) {
+      std::set<usize> tails;
+      for (usize k = pick(1, 2); k > 0; --k) {
+        std::vector<std::string> rhs{
+            nonterminator_name(self), lead(claim_lead(tails))
+        };
+        append_body(rhs, 0, false);
+        alternatives.push_back(std::move(rhs));
+      }
+    } else if (roll(options_.nullable)) {
+      nullable_[self] = true;
+      alternatives.push_back({"ε"});
+    }
+
+    return alternatives;
+  }
+
+public:
+  Generator(Options options):
+      options_(options), rng_(options.seed),
+      first_(options.nonterminators), nullable_(options.nonterminators),
+      children_(options.nonterminators) {
+    for (usize i = 1; i < options_.nonterminators; ++i)
+      children_[pick(0, i - 1)].push_back(i);
+  }
+
+  // The lines of the grammar, defined bottom up so that the FIRST sets of
+  // the nonterminators further down are known.
+  std::vector<std::string> lines() {
+    std::vector<std::string> lines(options_.nonterminators);
+    for (usize i = options_.nonterminators; i-- > 0;) {
+      std::string line = nonterminator_name(i) + " ->";
+      bool first = true;
+      for (const auto &rhs : alternatives(i)) {
+        line += first ? "" : " |";
+        first = false;
+        for (const auto &symbol : rhs)
+          line.append(1, ' ').append(symbol);
+      }
+      lines[i] = std::move(line);
+    }
+    return lines;
+  }
+};
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--nonterminals" && has_value)
+      options.nonterminators = std::max<usize>(1, std::stoul(argv[++i]));
+    else if (arg == "--terminals" && has_value)
+      options.terminators = std::stoul(argv[++i]);
+    else if (arg == "--separators" && has_value)
+      options.separators = std::max<usize>(1, std::stoul(argv[++i]));
+    else if (arg == "--alternatives" && has_value)
+      options.alternatives = std::max<usize>(1, std::stoul(argv[++i]));
+    else if (arg == "--length" && has_value)
+      options.length = std::stoul(argv[++i]);
+    else if (arg == "--nullable" && has_value)
+      options.nullable = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+    else if (arg == "--left-recursive" && has_value)
+      options.left_recursive = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+    else if (arg == "--common-prefix" && has_value)
+      options.common_prefix = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+    else if (arg == "--seed" && has_value)
+      options.seed = std::stoull(argv[++i]);
+    else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--nonterminals N] [--terminals N] [--separators N]"
+                << " [--alternatives N] [--length N] [--nullable P]"
+                << " [--left-recursive P] [--common-prefix P] [--seed N]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  // Leads for the plain alternatives, and one more for a common prefix; the
+  // tails of a prefix or of left recursion need three at most.
+  options.terminators = std::max(options.terminators, options.alternatives + 1);
+  options.terminators = std::max<usize>(options.terminators, 3);
+
+  for (const auto &line : Generator(options).lines())
+    std::cout << line << '\n';
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,308 @@
+// Generates a direct-coded recursive-descent parser from a grammar file, as
+// a self-contained C++ header that needs nothing from ExParser. The grammar
+// goes through the same transformations and analysis as in `Parser`; each
+// nonterminator then becomes a function switching on the lookahead, with
+// symbols as enum constants. Terminator ids and production indices are
+// those of the prediction table, so symbol streams and derivations carry
+// over unchanged.
+//
+//   parser_gen GRAMMAR OUTPUT [NAMESPACE]
+
+#include "parser/grammar.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ep;
+
+namespace {
+
+// Spells a symbol name as a C++ identifier.
+std::string identifier(std::string_view name) {
+  std::string buf;
+  for (char c : name) {
+    if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+      buf.push_back(c);
+    else if (c == '\'')
+      buf.append("_prime");
+    else if (c == '+')
+      buf.append("plus");
+    else if (c == '-')
+      buf.append("minus");
+    else if (c == '*')
+      buf.append("star");
+    else if (c == '/')
+      buf.append("slash");
+    else if (c == '(')
+      buf.append("lparen");
+    else if (c == ')')
+      buf.append("rparen");
+    else
+      buf.append(std::format("x{:02x}", static_cast<unsigned char>(c)));
+  }
+  if (buf.empty() || std::isdigit(static_cast<unsigned char>(buf[0])))
+    buf.insert(buf.begin(), '_');
+  return buf;
+}
+
+// Identifiers for `count` symbols of one kind, made unique by appending
+// the id where two names spell the same.
+std::vector<std::string>
+identifiers(const SymbolTable &symbols, Symbol::Type type, usize count) {
+  std::vector<std::string> names;
+  std::set<std::string> taken;
+  for (u32 i = 0; i < count; ++i) {
+    auto name = identifier(symbols.name({i, type}));
+    if (type == Symbol::Terminator && i == 0)
+      name = "empty";
+    else if (type == Symbol::Terminator && i == 1)
+      name = "end";
+    if (!taken.insert(name).second)
+      name += std::format("_{}", i);
+    taken.insert(name);
+    names.push_back(std::move(name));
+  }
+  return names;
+}
+
+std::string escape(std::string_view name) {
+  std::string buf;
+  for (char c : name) {
+    if (c == '"' || c == '\\')
+      buf.push_back('\\');
+    buf.push_back(c);
+  }
+  return buf;
+}
+
+std::string generate(
+    const Grammar &grammar, const PredictionTable &table,
+    std::string_view grammar_path, std::string_view ns
+) {
+  const auto &symbols = grammar.symbols;
+  auto terminators = identifiers(
+      symbols, Symbol::Terminator, table.terminator_count
+  );
+  auto nonterminators = identifiers(
+      symbols, Symbol::NonTerminator, table.nonterminator_count
+  );
+
+  std::ostringstream out;
+  out << std::format(
+      "// Generated by parser_gen from {}; do not edit.\n"
+      "//\n"
+      "// Recursive-descent parser for the LL(1) grammar\n"
+      "//\n",
+      grammar_path
+  );
+  for (u32 i = 0; i < table.productions.size(); ++i)
+    out << std::format(
+        "//   {:>3}  {}\n", i,
+        to_string({table.productions[i].lhs, table.rhs(i)}, symbols)
+    );
+  out << "\n#pragma once\n\n"
+         "#include <cstdint>\n"
+         "#include <span>\n"
+         "#include <string_view>\n\n";
+  out << std::format("namespace {} {{\n\n", ns);
+
+  out << "enum class Terminal : std::uint32_t {\n";
+  for (u32 i = 0; i < terminators.size(); ++i)
+    out << std::format("  {} = {},\n", terminators[i], i);
+  out << "};\n\n";
+  out << "enum class Nonterminal : std::uint32_t {\n";
+  for (u32 i = 0; i < nonterminators.size(); ++i)
+    out << std::format("  {} = {},\n", nonterminators[i], i);
+  out << "};\n\n";
+
+  out << "inline constexpr std::string_view terminal_names[] = {\n";
+  for (u32 i = 0; i < terminators.size(); ++i)
+    out << std::format(
+        "    \"{}\",\n", escape(symbols.to_string({i, Symbol::Terminator}))
+    );
+  out << "};\n\n";
+  out << "inline constexpr std::string_view nonterminal_names[] = {\n";
+  for (u32 i = 0; i < nonterminators.size(); ++i)
+    out << std::format(
+        "    \"{}\",\n", escape(symbols.name({i, Symbol::NonTerminator}))
+    );
+  out << "};\n\n";
+  out << "// The left hand side of every production, by index.\n"
+         "inline constexpr Nonterminal production_lhs[] = {\n";
+  for (const auto &production : table.productions)
+    out << std::format(
+        "    Nonterminal::{},\n", nonterminators[production.lhs.id]
+    );
+  out << "};\n\n";
+
+  out << "namespace detail {\n\n"
+         "template<class OnExpand>\n"
+         "struct Parser {\n"
+         "  const Terminal *pos;\n"
+         "  OnExpand &on_expand;\n\n"
+         "  bool match(Terminal terminal) {\n"
+         "    if (*pos != terminal)\n"
+         "      return false;\n"
+         "    ++pos;\n"
+         "    return true;\n"
+         "  }\n";
+  for (const auto &name : nonterminators)
+    out << std::format("\n  bool parse_{}();\n", name);
+  out << "};\n";
+
+  auto call = [&](Symbol symbol) {
+    return symbol.type == Symbol::Terminator
+               ? std::format("match(Terminal::{})", terminators[symbol.id])
+               : std::format("parse_{}()", nonterminators[symbol.id]);
+  };
+
+  for (u32 nt = 0; nt < table.nonterminator_count; ++nt) {
+    Symbol lhs{nt, Symbol::NonTerminator};
+
+    // The lookaheads predicting each production, in production order.
+    std::map<u32, std::vector<u32>> cases;
+    for (u32 t = 1; t < table.terminator_count; ++t)
+      if (auto production = table.lookup(lhs, {t, Symbol::Terminator});
+          production != PredictionTable::no_entry)
+        cases[production].push_back(t);
+
+    // A production ending in the nonterminator itself loops instead of
+    // recursing, so that the tails made by eliminating left recursion take
+    // constant stack.
+    bool loops = false;
+    for (const auto &[production, _] : cases) {
+      auto rhs = table.rhs(production);
+      loops |= !rhs.empty() && rhs.back() == lhs;
+    }
+
+    out << std::format(
+        "\ntemplate<class OnExpand>\n"
+        "bool Parser<OnExpand>::parse_{}() {{\n",
+        nonterminators[nt]
+    );
+    std::string indent = loops ? "    " : "  ";
+    if (loops)
+      out << "  for (;;) {\n";
+    out << indent << "switch (*pos) {\n";
+    for (const auto &[production, lookaheads] : cases) {
+      for (auto t : lookaheads)
+        out << indent << std::format("  case Terminal::{}:\n", terminators[t]);
+      auto rhs = table.rhs(production);
+      out << indent
+          << std::format(
+                 "    on_expand(std::uint32_t{{{}}}); // {}\n", production,
+                 to_string({lhs, rhs}, symbols)
+             );
+
+      bool tail = !rhs.empty() && rhs.back() == lhs;
+      std::vector<std::string> calls;
+      for (auto symbol : tail ? rhs.first(rhs.size() - 1) : rhs)
+        if (symbol != Symbol::empty_symbol())
+          calls.push_back(call(symbol));
+
+      if (tail) {
+        for (const auto &c : calls)
+          out << indent << std::format("    if (!{})\n", c) << indent
+              << "      return false;\n";
+        out << indent << "    continue;\n";
+      } else if (calls.empty()) {
+        out << indent << "    return true;\n";
+      } else {
+        std::string line = indent + "    return " + calls[0];
+        for (usize i = 1; i < calls.size(); ++i)
+          line += " && " + calls[i];
+        if (line.size() + 1 > 80) {
+          line = indent + "    return " + calls[0];
+          for (usize i = 1; i < calls.size(); ++i)
+            line += " &&\n" + indent + "           " + calls[i];
+        }
+        out << line << ";\n";
+      }
+    }
+    out << indent << "  default:\n" << indent << "    return false;\n";
+    out << indent << "}\n";
+    if (loops)
+      out << "  }\n";
+    out << "}\n";
+  }
+
+  out << "\n} // namespace detail\n\n";
+  out << std::format(
+      "// Whether `input`, which must end with `Terminal::end`, is a sentence\n"
+      "// of the grammar. `on_expand(production)` is called for every\n"
+      "// production expanded, in the order of a leftmost derivation.\n"
+      "template<class OnExpand>\n"
+      "bool parse(std::span<const Terminal> input, OnExpand &&on_expand) {{\n"
+      "  detail::Parser<OnExpand> parser{{input.data(), on_expand}};\n"
+      "  return parser.parse_{}() && *parser.pos == Terminal::end;\n"
+      "}}\n\n"
+      "inline bool recognize(std::span<const Terminal> input) {{\n"
+      "  return parse(input, [](std::uint32_t) {{}});\n"
+      "}}\n\n"
+      "}} // namespace {}\n",
+      nonterminators[0], ns
+  );
+  return out.str();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 4) {
+    std::cerr << "Usage: " << argv[0] << " GRAMMAR OUTPUT [NAMESPACE]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *grammar_path = argv[1], *output_path = argv[2];
+  std::string ns = argc > 3 ? argv[3] : "generated";
+
+  std::ifstream in(grammar_path);
+  if (!in) {
+    std::cerr << std::format("Cannot open {}", grammar_path) << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string source;
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+    if (!source.empty())
+      source.push_back('\n');
+    source += line;
+  }
+
+  // As in `static_grammar`, the start symbol is the lhs of the first line.
+  auto grammar = Grammar::from_str(source);
+  Symbol start_symbol{0, Symbol::NonTerminator};
+  grammar.eliminate_left_recursion();
+  grammar.extract_left_factoring();
+  auto first_set = grammar.build_first_set();
+  auto follow_set = grammar.build_follow_set(first_set, start_symbol);
+  if (auto conflicts = grammar.is_ll1(first_set, follow_set); conflicts) {
+    std::cerr << std::format("Grammar is not LL(1):\n{}", *conflicts)
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto table = grammar.build_prediction_table(first_set, follow_set);
+
+  std::ofstream out(output_path);
+  out << generate(
+      grammar, table, std::filesystem::path(grammar_path).filename().string(),
+      ns
+  );
+  if (!out.flush()) {
+    std::cerr << std::format("Cannot write {}", output_path) << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}